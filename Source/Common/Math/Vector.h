@@ -86,12 +86,12 @@ public:
     };
 
 public:
-    VLN_FINLINE b32 operator!=(const VVector3& Other)
+    VLN_FINLINE b32 operator!=(const VVector3& Other) const
     {
         return X != Other.X || Y != Other.Y || Z != Other.Z;
     }
 
-    VLN_FINLINE b32 operator==(const VVector3& Other)
+    VLN_FINLINE b32 operator==(const VVector3& Other) const
     {
         return X == Other.X && Y == Other.Y && Z == Other.Z;
     }
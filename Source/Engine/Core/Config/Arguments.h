@@ -29,3 +29,27 @@ static constexpr const char* LimitFPSArgLong = "/LimitFPS";
 
 static constexpr const char* BackfaceRemovalArgShort = "/bfr";
 static constexpr const char* BackfaceRemovalArgLong = "/BackfaceRemoval";
+
+static constexpr const char* TextureCacheArgShort = "/tc";
+static constexpr const char* TextureCacheArgLong = "/TextureCache";
+
+static constexpr const char* PalettizedTexturesArgShort = "/pt";
+static constexpr const char* PalettizedTexturesArgLong = "/PalettizedTextures";
+
+static constexpr const char* BilinearUpscaleArgShort = "/bu";
+static constexpr const char* BilinearUpscaleArgLong = "/BilinearUpscale";
+
+static constexpr const char* PresentThreadArgShort = "/prt";
+static constexpr const char* PresentThreadArgLong = "/PresentThread";
+
+static constexpr const char* DynamicResolutionArgShort = "/dr";
+static constexpr const char* DynamicResolutionArgLong = "/DynamicResolution";
+
+static constexpr const char* OcclusionCullingArgShort = "/oc";
+static constexpr const char* OcclusionCullingArgLong = "/OcclusionCulling";
+
+static constexpr const char* AnimationLODArgShort = "/al";
+static constexpr const char* AnimationLODArgLong = "/AnimationLOD";
+
+static constexpr const char* ShadowMapArgShort = "/sm";
+static constexpr const char* ShadowMapArgLong = "/ShadowMap";
@@ -76,6 +76,54 @@ static void BackfaceRemovalArg(char** Argv, i32& Cursor)
     Cursor += 1;
 }
 
+static void TextureCacheArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bTextureCache = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void PalettizedTexturesArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bPalettizedTextures = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void BilinearUpscaleArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bBilinearUpscale = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void PresentThreadArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bPresentThread = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void DynamicResolutionArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bDynamicResolution = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void OcclusionCullingArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bOcclusionCulling = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void AnimationLODArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bAnimationLOD = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
+static void ShadowMapArg(char** Argv, i32& Cursor)
+{
+    Config.RenderSpec.bShadowMap = std::atoi(Argv[Cursor]);
+    Cursor += 1;
+}
+
 static TMap<VString, ArgHandler> ArgHandlers = {
     { LauncherArgShort, { LauncherArg } },
     { LauncherArgLong,  { LauncherArg } },
@@ -107,6 +155,28 @@ static TMap<VString, ArgHandler> ArgHandlers = {
 
     { BackfaceRemovalArgShort, { BackfaceRemovalArg, 1 }},
     { BackfaceRemovalArgLong,  { BackfaceRemovalArg, 1 }},
+
+    { TextureCacheArgShort, { TextureCacheArg, 1 }},
+    { TextureCacheArgLong,  { TextureCacheArg, 1 }},
+
+    { PalettizedTexturesArgShort, { PalettizedTexturesArg, 1 }},
+    { PalettizedTexturesArgLong,  { PalettizedTexturesArg, 1 }},
+
+    { BilinearUpscaleArgShort, { BilinearUpscaleArg, 1 }},
+    { BilinearUpscaleArgLong,  { BilinearUpscaleArg, 1 }},
+
+    { PresentThreadArgShort, { PresentThreadArg, 1 }},
+    { PresentThreadArgLong,  { PresentThreadArg, 1 }},
+
+    { DynamicResolutionArgShort, { DynamicResolutionArg, 1 }},
+    { DynamicResolutionArgLong,  { DynamicResolutionArg, 1 }},
+
+    { OcclusionCullingArgShort, { OcclusionCullingArg, 1 }},
+    { OcclusionCullingArgLong,  { OcclusionCullingArg, 1 }},
+    { AnimationLODArgShort,     { AnimationLODArg, 1 }},
+    { AnimationLODArgLong,      { AnimationLODArg, 1 }},
+    { ShadowMapArgShort,        { ShadowMapArg, 1 }},
+    { ShadowMapArgLong,         { ShadowMapArg, 1 }},
 };
 
 void VConfig::StartUp(i32 Argc, char** Argv)
@@ -16,19 +16,42 @@ public:
     static constexpr VColorARGB DefaultDebugTextColor = MAP_XRGB32(0xDD, 0xCC, 0xDD);
 
 public: /** Set by user */
-    b32 bLimitFPS        : 1;
-    b32 bRenderSolid     : 1;
-    b32 bBackfaceRemoval : 1;
-    b32 bPostProcessing  : 1;
-    b32 bRenderUI        : 1;
+    b32 bLimitFPS           : 1;
+    b32 bRenderSolid        : 1;
+    b32 bBackfaceRemoval    : 1;
+    b32 bPostProcessing     : 1;
+    b32 bRenderUI           : 1;
+    b32 bTextureCache       : 1;
+    b32 bPalettizedTextures : 1;
+    b32 bBilinearUpscale    : 1; /** If render target is smaller than window */
+    b32 bPresentThread      : 1; /** Keeps one frame in flight, read on start up */
+    b32 bDynamicResolution  : 1; /** Scales viewport down from RenderScale to hold TargetFPS */
+    b32 bOcclusionCulling   : 1; /** Entities hidden behind terrain are skipped */
+    b32 bAnimationLOD       : 1; /** Distant or small on screen meshes show fixed frames updated at reduced rate */
+    b32 bShadowMap          : 1; /** Shadows are looked up in depth map from light instead of projected on Y plane */
 
     f32 RenderScale = 1.0f;
+    f32 MinDynamicRenderScale = 0.5f; /** Relative to RenderScale */
 
     i32 TargetFPS      = 60;
     i32 TargetFixedFPS = 60;
 
     i32 MaxMipMaps = 8;
 
+    /** Palettized textures are used further than this, where texture interpolation is affine anyway */
+    f32 PalettizedTextureDistance = 50000.0f;
+
+    /** Mesh diameter relative to viewplane height, below them animation updates every 2nd and 4th frame */
+    f32 AnimationLODHalfRateSize = 0.15f;
+    f32 AnimationLODQuarterRateSize = 0.05f;
+
+    /** Camera space depth, further than them animation updates every 2nd and 4th frame however big mesh is */
+    f32 AnimationLODHalfRateDistance = 25000.0f;
+    f32 AnimationLODQuarterRateDistance = 50000.0f;
+
+    /** Part of color taken by planar shadows, 1 is black */
+    f32 ShadowIntensity = 0.65f;
+
     VVector3 PostProcessColorCorrection = DefaultColorCorrection;
 
     VVector2i DebugTextPosition;
@@ -50,16 +73,25 @@ private: /** Set by rendering engine */
 public:
     VRenderSpecification()
     {
-        bLimitFPS        = false;
-        bRenderSolid     = true;
-        bBackfaceRemoval = true;
-        bPostProcessing  = true;
-        bRenderUI        = true;
+        bLimitFPS           = false;
+        bRenderSolid        = true;
+        bBackfaceRemoval    = true;
+        bPostProcessing     = true;
+        bRenderUI           = true;
+        bTextureCache       = true;
+        bPalettizedTextures = false;
+        bBilinearUpscale    = false;
+        bPresentThread      = true;
+        bDynamicResolution  = false;
+        bOcclusionCulling   = true;
+        bAnimationLOD       = true;
+        bShadowMap          = false;
     }
 
     friend class VRenderer;
     friend class VSurface;
     friend class VCamera;
+    friend class VTexture;
 };
 
 }
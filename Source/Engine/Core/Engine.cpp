@@ -14,6 +14,8 @@ void VEngine::ShutDown()
     Math.ShutDown();
     Window.ShutDown();
     EventBus.ShutDown();
+    FrameArena.ShutDown();
+    JobSystem.ShutDown();
     Config.ShutDown();
     DebugLog.ShutDown();
 }
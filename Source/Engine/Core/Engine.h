@@ -4,6 +4,8 @@
 #include "Common/Platform/Platform.h"
 #include "Common/Math/Math.h"
 #include "Engine/Core/DebugLog.h"
+#include "Engine/Core/JobSystem.h"
+#include "Engine/Core/FrameArena.h"
 #include "Engine/Core/Window.h"
 #include "Engine/Core/Time.h"
 #include "Engine/Core/Events/EventBus.h"
@@ -36,6 +38,8 @@ void VEngine::StartUp(i32 Argc, char** Argv)
 {
     DebugLog.StartUp();
     Config.StartUp(Argc, Argv);
+    JobSystem.StartUp();
+    FrameArena.StartUp();
     EventBus.StartUp();
     Window.StartUp();
     Math.StartUp();
@@ -0,0 +1,157 @@
+#include "Engine/Core/DebugLog.h"
+#include "Engine/Core/FrameArena.h"
+
+namespace Volition
+{
+
+VLN_DEFINE_LOG_CHANNEL(hLogFrameArena, "FrameArena");
+
+void VFrameArena::StartUp()
+{
+    FrameIndex = 0;
+}
+
+void VFrameArena::ShutDown()
+{
+    for (auto& Frame : Frames)
+    {
+        for (auto& Arena : Frame.Threads)
+        {
+            ResetThreadArena(Arena);
+
+            FreeBlock(Arena.Block);
+            Arena.Block = nullptr;
+            Arena.Capacity = 0;
+        }
+    }
+}
+
+void VFrameArena::NextFrame()
+{
+    FrameIndex = (FrameIndex + 1) % NumFrames;
+
+    for (auto& Arena : Frames[FrameIndex].Threads)
+    {
+        ResetThreadArena(Arena);
+    }
+}
+
+i32 VFrameArena::GetNumAllocations() const
+{
+    i32 NumAllocations = 0;
+    for (const auto& Arena : Frames[FrameIndex].Threads)
+    {
+        NumAllocations += Arena.NumAllocations;
+    }
+    return NumAllocations;
+}
+
+VSizeType VFrameArena::GetNumBytes() const
+{
+    VSizeType NumBytes = 0;
+    for (const auto& Arena : Frames[FrameIndex].Threads)
+    {
+        NumBytes += Arena.NumBytes;
+    }
+    return NumBytes;
+}
+
+VSizeType VFrameArena::GetReservedBytes() const
+{
+    VSizeType NumBytes = 0;
+    for (const auto& Frame : Frames)
+    {
+        for (const auto& Arena : Frame.Threads)
+        {
+            NumBytes += Arena.Capacity + Arena.FullBytes;
+        }
+    }
+    return NumBytes;
+}
+
+void* VFrameArena::AllocateSlow(VThreadArena& Arena, VSizeType Size)
+{
+    // Current block is kept until reset, pointers into it are still in use
+    if (Arena.Block)
+    {
+        CheckGuards(Arena.Block, Arena.Offset);
+
+        Arena.FullBlocks.EmplaceBack(Arena.Block);
+        Arena.FullBytes += Arena.Capacity;
+    }
+
+    const VSizeType AllocationSize = HeaderSize + AlignUp(Size) + GuardSize;
+
+    Arena.Capacity = VLN_MAX(VLN_MAX(Arena.Capacity * 2, MinBlockSize), AllocationSize);
+    Arena.Block = AllocateBlock(Arena.Capacity);
+    Arena.Offset = 0;
+
+    return Allocate(Size);
+}
+
+void VFrameArena::ResetThreadArena(VThreadArena& Arena)
+{
+    CheckGuards(Arena.Block, Arena.Offset);
+
+    // Block grows to fit the whole previous frame, so overflow happens only while usage is growing
+    if (Arena.FullBlocks.GetLength() > 0)
+    {
+        for (u8* Block : Arena.FullBlocks)
+        {
+            FreeBlock(Block);
+        }
+
+        const VSizeType NewCapacity = Arena.FullBytes + Arena.Capacity;
+        VLN_NOTE(hLogFrameArena, "Sub-arena grew to %u KB\n", (u32)(NewCapacity / 1024));
+
+        FreeBlock(Arena.Block);
+        Arena.Block = AllocateBlock(NewCapacity);
+        Arena.Capacity = NewCapacity;
+
+        Arena.FullBlocks.Clear();
+        Arena.FullBytes = 0;
+    }
+
+    Arena.Offset = 0;
+    Arena.NumAllocations = 0;
+    Arena.NumBytes = 0;
+}
+
+void VFrameArena::CheckGuards(const u8* Block, VSizeType UsedSize)
+{
+#if VLN_FRAME_ARENA_GUARDS
+    for (VSizeType Offset = 0; Offset < UsedSize; )
+    {
+        const VSizeType Size = *(const VSizeType*)(Block + Offset);
+        const u8* Guard = Block + Offset + HeaderSize + Size;
+        const VSizeType NumGuardBytes = AlignUp(Size) - Size + GuardSize;
+
+        for (VSizeType i = 0; i < NumGuardBytes; ++i)
+        {
+            if (Guard[i] != GuardValue)
+            {
+                VLN_ERROR(hLogFrameArena, "Allocation of %u bytes was overrun\n", (u32)Size);
+                VLN_ASSERT(false);
+                break;
+            }
+        }
+
+        Offset += HeaderSize + AlignUp(Size) + GuardSize;
+    }
+#endif
+}
+
+u8* VFrameArena::AllocateBlock(VSizeType Size)
+{
+    return (u8*)::operator new(Size, std::align_val_t(Alignment));
+}
+
+void VFrameArena::FreeBlock(u8* Block)
+{
+    if (Block)
+    {
+        ::operator delete(Block, std::align_val_t(Alignment));
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <new>
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Platform/Platform.h"
+#include "Common/Platform/Assert.h"
+#include "Common/Platform/Memory.h"
+#include "Engine/Core/JobSystem.h"
+
+/** Guard bytes after every allocation, checked when frame is reset */
+#ifndef VLN_FRAME_ARENA_GUARDS
+    #ifdef _DEBUG
+        #define VLN_FRAME_ARENA_GUARDS 1
+    #else
+        #define VLN_FRAME_ARENA_GUARDS 0
+    #endif
+#endif
+
+namespace Volition
+{
+
+/**
+    Bump allocator for data which lives during one frame, every thread of job system has own sub-arena.
+    Allocations are valid until two more NextFrame() calls, because present thread reads data of previous frame
+    and some of it is queued before renderer starts that frame
+*/
+class VFrameArena
+{
+public:
+    static constexpr i32f NumFrames = 3;
+    static constexpr VSizeType Alignment = 16; /** Every allocation is aligned to it */
+    static constexpr VSizeType MinBlockSize = 64 * 1024;
+
+private:
+    static constexpr VSizeType GuardSize = VLN_FRAME_ARENA_GUARDS ? Alignment : 0;
+    static constexpr VSizeType HeaderSize = VLN_FRAME_ARENA_GUARDS ? Alignment : 0;
+    static constexpr u8 GuardValue = 0xFD;
+
+    struct alignas(64) VThreadArena
+    {
+        u8* Block = nullptr;
+        VSizeType Capacity = 0;
+        VSizeType Offset = 0;
+
+        /** Blocks which overflowed during this frame, freed on reset when block grows to fit all of them */
+        TArray<u8*> FullBlocks;
+        VSizeType FullBytes = 0;
+
+        i32 NumAllocations = 0;
+        VSizeType NumBytes = 0;
+    };
+
+    struct VFrame
+    {
+        VThreadArena Threads[VJobSystem::MaxThreads];
+    };
+
+private:
+    VFrame Frames[NumFrames];
+    i32 FrameIndex = 0;
+
+public:
+    void StartUp();
+    void ShutDown();
+
+    /** Switches to the oldest frame and resets it */
+    void NextFrame();
+
+    /** Only from thread which has index in job system, memory isn't initialized */
+    void* Allocate(VSizeType Size);
+
+    template<typename T>
+    VLN_FINLINE T* AllocateArray(VSizeType Count)
+    {
+        static_assert(alignof(T) <= Alignment);
+        return (T*)Allocate(sizeof(T) * Count);
+    }
+
+    /** Of current frame over all threads */
+    i32 GetNumAllocations() const;
+    VSizeType GetNumBytes() const;
+
+    /** Of all frames over all threads */
+    VSizeType GetReservedBytes() const;
+
+private:
+    void* AllocateSlow(VThreadArena& Arena, VSizeType Size);
+    void ResetThreadArena(VThreadArena& Arena);
+
+    /** Asserts if any allocation in the used part of block wrote past its end */
+    static void CheckGuards(const u8* Block, VSizeType UsedSize);
+
+    static u8* AllocateBlock(VSizeType Size);
+    static void FreeBlock(u8* Block);
+
+    VLN_FINLINE static VSizeType AlignUp(VSizeType Size)
+    {
+        return (Size + Alignment - 1) & ~(Alignment - 1);
+    }
+};
+
+inline VFrameArena FrameArena;
+
+VLN_FINLINE void* VFrameArena::Allocate(VSizeType Size)
+{
+    VThreadArena& Arena = Frames[FrameIndex].Threads[VJobSystem::GetThreadIndex()];
+
+    const VSizeType AllocationSize = HeaderSize + AlignUp(Size) + GuardSize;
+    if (Arena.Offset + AllocationSize > Arena.Capacity)
+    {
+        return AllocateSlow(Arena, Size);
+    }
+
+    u8* Result = Arena.Block + Arena.Offset;
+    Arena.Offset += AllocationSize;
+
+    ++Arena.NumAllocations;
+    Arena.NumBytes += Size;
+
+#if VLN_FRAME_ARENA_GUARDS
+    *(VSizeType*)Result = Size;
+    Result += HeaderSize;
+    Memory.MemSetByte(Result + Size, GuardValue, AlignUp(Size) - Size + GuardSize);
+#endif
+
+    return Result;
+}
+
+}
@@ -0,0 +1,154 @@
+#include "Engine/Core/DebugLog.h"
+#include "Engine/Core/JobSystem.h"
+
+namespace Volition
+{
+
+VLN_DEFINE_LOG_CHANNEL(hLogJobSystem, "JobSystem");
+
+thread_local i32 VJobSystem::ThreadIndex = 0;
+thread_local b32 VJobSystem::bDispatching = false;
+
+void VJobSystem::StartUp()
+{
+    JobGeneration = 0;
+    bShuttingDown = false;
+
+    NextBatch.store(0, std::memory_order_relaxed);
+    NumPendingBatches.store(0, std::memory_order_relaxed);
+    NumActiveWorkers.store(0, std::memory_order_relaxed);
+
+    // Leave one hardware thread for the caller
+    i32 NumWorkers = (i32)std::thread::hardware_concurrency() - 1;
+    NumWorkers = VLN_MAX(NumWorkers, 0);
+    NumWorkers = VLN_MIN(NumWorkers, (i32)MaxThreads - 1);
+
+    NumThreads = NumWorkers + 1;
+
+    Workers.Reserve(NumWorkers);
+    for (i32f i = 0; i < NumWorkers; ++i)
+    {
+        Workers.EmplaceBack(&VJobSystem::WorkerLoop, this, (i32)(i + 1));
+    }
+
+    VLN_NOTE(hLogJobSystem, "Started with %d threads\n", NumThreads);
+}
+
+void VJobSystem::ShutDown()
+{
+    {
+        std::lock_guard<std::mutex> Lock(WakeMutex);
+        bShuttingDown = true;
+    }
+    WakeCondition.notify_all();
+
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+
+    Workers.Clear();
+    NumThreads = 1;
+}
+
+void VJobSystem::Dispatch(VBatchFunction Function, const void* Context, i32 Count, i32 MinBatchSize)
+{
+    // Aim for a few batches per thread so faster threads can steal the rest
+    i32 BatchSize = (Count + NumThreads * 4 - 1) / (NumThreads * 4);
+    BatchSize = VLN_MAX(BatchSize, MinBatchSize);
+    BatchSize = VLN_MAX(BatchSize, 1);
+
+    const i32 NumBatches = (Count + BatchSize - 1) / BatchSize;
+
+    // Nested call from a batch can't wait for its own job
+    if (NumThreads <= 1 || NumBatches <= 1 || ThreadIndex != 0 || bDispatching)
+    {
+        Function(Context, 0, Count);
+        return;
+    }
+
+    // Present thread and main thread take turns, so each job still gets all workers
+    while (!DispatchLock.TryAcquire())
+    {
+        std::this_thread::yield();
+    }
+    bDispatching = true;
+
+    {
+        std::unique_lock<std::mutex> Lock(WakeMutex);
+
+        // Workers join a job only under the mutex, so once they're gone nobody reads the old one
+        while (NumActiveWorkers.load(std::memory_order_acquire) > 0)
+        {
+            VLN_PAUSE();
+        }
+
+        Job = { Function, Context, BatchSize, NumBatches, Count };
+        NextBatch.store(0, std::memory_order_relaxed);
+        NumPendingBatches.store(NumBatches, std::memory_order_relaxed);
+
+        ++JobGeneration;
+    }
+    WakeCondition.notify_all();
+
+    // Calling thread does its share too
+    RunBatches(Job);
+
+    while (NumPendingBatches.load(std::memory_order_acquire) > 0)
+    {
+        VLN_PAUSE();
+    }
+
+    bDispatching = false;
+    DispatchLock.Release();
+}
+
+void VJobSystem::RunBatches(const VJob& InJob)
+{
+    for ( ;; )
+    {
+        const i32 Batch = NextBatch.fetch_add(1, std::memory_order_relaxed);
+        if (Batch >= InJob.NumBatches)
+        {
+            break;
+        }
+
+        const i32 Begin = Batch * InJob.BatchSize;
+        const i32 End = VLN_MIN(Begin + InJob.BatchSize, InJob.Count);
+
+        InJob.Function(InJob.Context, Begin, End);
+
+        NumPendingBatches.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void VJobSystem::WorkerLoop(i32 Index)
+{
+    ThreadIndex = Index;
+    u32 LastGeneration = 0;
+
+    for ( ;; )
+    {
+        VJob LocalJob;
+
+        {
+            std::unique_lock<std::mutex> Lock(WakeMutex);
+            WakeCondition.wait(Lock, [this, LastGeneration]() { return bShuttingDown || JobGeneration != LastGeneration; });
+
+            if (bShuttingDown)
+            {
+                return;
+            }
+
+            LastGeneration = JobGeneration;
+            LocalJob = Job;
+            NumActiveWorkers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        RunBatches(LocalJob);
+
+        NumActiveWorkers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+}
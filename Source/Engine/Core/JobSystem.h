@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Platform/Platform.h"
+#include "Common/Platform/Assert.h"
+#include "Common/Thread/SpinLock.h"
+
+namespace Volition
+{
+
+class VJobSystem
+{
+public:
+    static constexpr i32f MaxThreads = 16;
+
+private:
+    using VBatchFunction = void(*)(const void* Context, i32 Begin, i32 End);
+
+    struct VJob
+    {
+        VBatchFunction Function;
+        const void* Context;
+        i32 BatchSize;
+        i32 NumBatches;
+        i32 Count;
+    };
+
+private:
+    TArray<std::thread> Workers;
+    i32 NumThreads; /** Workers + calling thread */
+
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    u32 JobGeneration;
+    b32 bShuttingDown;
+
+    VJob Job;
+    std::atomic<i32> NextBatch;
+    std::atomic<i32> NumPendingBatches;
+    std::atomic<i32> NumActiveWorkers;
+
+    /** Only one parallel job can be in flight, nested calls run inline and calls from other threads wait for it */
+    VSpinLock DispatchLock;
+
+    static thread_local i32 ThreadIndex;
+    static thread_local b32 bDispatching; /** Thread holds DispatchLock */
+
+public:
+    void StartUp();
+    void ShutDown();
+
+    /** Splits [0, Count) into batches of at least MinBatchSize and runs Fun(Begin, End) on them, blocks until done */
+    template<typename FunT>
+    void ParallelFor(i32 Count, i32 MinBatchSize, const FunT& Fun);
+
+    VLN_FINLINE i32 GetNumThreads() const
+    {
+        return NumThreads;
+    }
+
+    /** 0 for the calling thread, [1, NumThreads) for workers */
+    VLN_FINLINE static i32 GetThreadIndex()
+    {
+        return ThreadIndex;
+    }
+
+private:
+    void Dispatch(VBatchFunction Function, const void* Context, i32 Count, i32 MinBatchSize);
+    void RunBatches(const VJob& InJob);
+    void WorkerLoop(i32 Index);
+};
+
+inline VJobSystem JobSystem;
+
+template<typename FunT>
+void VJobSystem::ParallelFor(i32 Count, i32 MinBatchSize, const FunT& Fun)
+{
+    if (Count <= 0)
+    {
+        return;
+    }
+
+    Dispatch(
+        [](const void* Context, i32 Begin, i32 End)
+        {
+            (*(const FunT*)Context)(Begin, End);
+        },
+        &Fun, Count, MinBatchSize
+    );
+}
+
+}
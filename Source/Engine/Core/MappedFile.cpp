@@ -0,0 +1,74 @@
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include "Engine/Core/MappedFile.h"
+
+namespace Volition
+{
+
+b32 VMappedFile::Open(const char* Path)
+{
+    Close();
+
+    HANDLE File = CreateFileA(
+        Path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+    );
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart <= 0 || FileSize.QuadPart > 0xFFFFFFFF)
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!Mapping)
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    const void* View = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!View)
+    {
+        CloseHandle(Mapping);
+        CloseHandle(File);
+        return false;
+    }
+
+    hFile = File;
+    hMapping = Mapping;
+    Data = (const u8*)View;
+    Size = (VSizeType)FileSize.QuadPart;
+
+    return true;
+}
+
+void VMappedFile::Close()
+{
+    if (Data)
+    {
+        UnmapViewOfFile(Data);
+        Data = nullptr;
+    }
+
+    if (hMapping)
+    {
+        CloseHandle(hMapping);
+        hMapping = nullptr;
+    }
+
+    if (hFile)
+    {
+        CloseHandle(hFile);
+        hFile = nullptr;
+    }
+
+    Size = 0;
+}
+
+}
\ No newline at end of file
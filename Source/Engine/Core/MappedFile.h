@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Platform/Platform.h"
+
+namespace Volition
+{
+
+/** Read-only memory-mapped file */
+class VMappedFile
+{
+    void* hFile = nullptr;
+    void* hMapping = nullptr;
+
+    const u8* Data = nullptr;
+    VSizeType Size = 0;
+
+public:
+    b32 Open(const char* Path);
+    void Close();
+
+    VLN_FINLINE b32 IsOpen() const
+    {
+        return Data != nullptr;
+    }
+
+    VLN_FINLINE const u8* GetData() const
+    {
+        return Data;
+    }
+
+    VLN_FINLINE VSizeType GetSize() const
+    {
+        return Size;
+    }
+};
+
+}
\ No newline at end of file
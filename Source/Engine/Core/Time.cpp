@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include "Common/Platform/Memory.h"
 #include "Engine/Core/Config/Config.h"
 #include "Engine/Core/Time.h"
@@ -7,10 +9,14 @@ namespace Volition
 
 void VTime::StartUp()
 {
-    MsFrameLimit = 1000 / Config.RenderSpec.TargetFPS;
+    CounterFrequency = SDL_GetPerformanceFrequency();
+    StartCounter = SDL_GetPerformanceCounter();
 
-    LastTick = 0;
+    FrameLimit = NsPerSecond / Config.RenderSpec.TargetFPS;
+
+    LastTick = GetNanoseconds();
     DeltaTime = 0.0f;
+    WorkTime = 0.0f;
 
     FixedDeltaTime = 1000.0f / Config.RenderSpec.TargetFixedFPS;
     AccumulatedFixedTime = 0.0f;
@@ -18,12 +24,21 @@ void VTime::StartUp()
     Memory.MemSetByte(DeltaTimeCache, 0, sizeof(DeltaTimeCache));
     DeltaTimeCacheIndex = 0;
     FPS = 0.0f;
+
+    FrameTimeHistoryIndex = 0;
+    NumFrameTimes = 0;
+
+    // Pessimistic until we measure real sleeps
+    SleepEstimate = 5.0 * NsPerMs;
+    SleepMean = 5.0 * NsPerMs;
+    SleepM2 = 0.0;
+    NumSleeps = 1;
 }
 
 void VTime::TickFrame()
 {
-    const u32 CurrentTick = GetTicks();
-    DeltaTime = (f32)(CurrentTick - LastTick);
+    const u64 CurrentTick = GetNanoseconds();
+    DeltaTime = (f32)((f64)(CurrentTick - LastTick) / (f64)NsPerMs);
     LastTick = CurrentTick;
 
     AccumulatedFixedTime += DeltaTime;
@@ -33,6 +48,10 @@ void VTime::TickFrame()
     DeltaTimeCache[DeltaTimeCacheIndex] = DeltaTime;
     DeltaTimeCacheIndex = (DeltaTimeCacheIndex + 1) % MaxCachedDeltaTimes;
 
+    FrameTimeHistory[FrameTimeHistoryIndex] = DeltaTime;
+    FrameTimeHistoryIndex = (FrameTimeHistoryIndex + 1) % MaxFrameTimeHistory;
+    NumFrameTimes = VLN_MIN(NumFrameTimes + 1, (i32)MaxFrameTimeHistory);
+
     f32 SumDeltaTimes = 0.0f;
     for (i32f i = 0; i < MaxCachedDeltaTimes; ++i)
     {
@@ -44,12 +63,59 @@ void VTime::TickFrame()
 
 void VTime::SyncFrame()
 {
+    const u64 CurrentTick = GetNanoseconds();
+    WorkTime = (f32)((f64)(CurrentTick - LastTick) / (f64)NsPerMs);
+
     if (Config.RenderSpec.bLimitFPS)
     {
-        while ((i32)GetTicks() - LastTick < MsFrameLimit)
+        Sleep(LastTick + FrameLimit);
+    }
+}
+
+f32 VTime::GetFrameTimePercentile(f32 Percentile) const
+{
+    if (!NumFrameTimes)
+    {
+        return 0.0f;
+    }
+
+    f32 Sorted[MaxFrameTimeHistory];
+    Memory.MemCopy(Sorted, FrameTimeHistory, NumFrameTimes * sizeof(f32));
+
+    Percentile = VLN_MIN(VLN_MAX(Percentile, 0.0f), 100.0f);
+    const i32 Index = VLN_MIN((i32)(Percentile * 0.01f * (f32)NumFrameTimes), NumFrameTimes - 1);
+
+    std::nth_element(Sorted, Sorted + Index, Sorted + NumFrameTimes);
+    return Sorted[Index];
+}
+
+void VTime::Sleep(u64 Until)
+{
+    // Sleep in 1 ms chunks while we're sure OS wakes us up in time
+    for ( ;; )
+    {
+        const u64 Now = GetNanoseconds();
+        if (Now >= Until || (f64)(Until - Now) <= SleepEstimate)
         {
-            VLN_PAUSE();
+            break;
         }
+
+        SDL_Delay(1);
+
+        const f64 Observed = (f64)(GetNanoseconds() - Now);
+
+        ++NumSleeps;
+        const f64 Delta = Observed - SleepMean;
+        SleepMean += Delta / (f64)NumSleeps;
+        SleepM2 += Delta * (Observed - SleepMean);
+
+        SleepEstimate = SleepMean + std::sqrt(SleepM2 / (f64)(NumSleeps - 1));
+    }
+
+    // Spin the rest
+    while (GetNanoseconds() < Until)
+    {
+        VLN_PAUSE();
     }
 }
 
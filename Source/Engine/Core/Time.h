@@ -11,11 +11,19 @@ namespace Volition
 class VTime
 {
     static constexpr i32f MaxCachedDeltaTimes = 10;
+    static constexpr i32f MaxFrameTimeHistory = 256; /** For percentiles */
+
+    static constexpr u64 NsPerSecond = 1'000'000'000;
+    static constexpr u64 NsPerMs = 1'000'000;
 
 private:
-    i32 MsFrameLimit;
-    i32 LastTick;
+    u64 CounterFrequency;
+    u64 StartCounter;
+
+    u64 FrameLimit; /** In ns */
+    u64 LastTick;   /** In ns */
     f32 DeltaTime;
+    f32 WorkTime; /** Part of last frame before sync */
 
     f32 FixedDeltaTime;
     i32f NumFixedUpdates;
@@ -25,6 +33,16 @@ private:
     i32 DeltaTimeCacheIndex;
     f32 FPS;
 
+    f32 FrameTimeHistory[MaxFrameTimeHistory];
+    i32 FrameTimeHistoryIndex;
+    i32 NumFrameTimes;
+
+    /** Running estimate of how long 1 ms sleep really takes, Welford's mean and variance */
+    f64 SleepEstimate;
+    f64 SleepMean;
+    f64 SleepM2;
+    i64 NumSleeps;
+
 public:
     void StartUp();
     void ShutDown() {}
@@ -32,16 +50,31 @@ public:
     void TickFrame();
     void SyncFrame();
 
+    /** Monotonic time since start up */
+    VLN_FINLINE u64 GetNanoseconds() const
+    {
+        const u64 Counter = SDL_GetPerformanceCounter() - StartCounter;
+
+        // Split to avoid overflow of Counter * NsPerSecond
+        return (Counter / CounterFrequency) * NsPerSecond + ((Counter % CounterFrequency) * NsPerSecond) / CounterFrequency;
+    }
+
     VLN_FINLINE i32 GetTicks() const
     {
-        return SDL_GetTicks();
+        return (i32)(GetNanoseconds() / NsPerMs);
     }
 
+    /** In ms, fractional */
     VLN_FINLINE f32 GetDeltaTime() const
     {
         return DeltaTime;
     }
 
+    VLN_FINLINE f32 GetWorkTime() const
+    {
+        return WorkTime;
+    }
+
     VLN_FINLINE f32 GetFixedDeltaTime() const
     {
         return FixedDeltaTime;
@@ -56,6 +89,12 @@ public:
     {
         return FPS;
     }
+
+    /** Frame time in ms which given percent [0, 100] of recent frames didn't exceed */
+    f32 GetFrameTimePercentile(f32 Percentile) const;
+
+private:
+    void Sleep(u64 Until);
 };
 
 inline VTime Time;
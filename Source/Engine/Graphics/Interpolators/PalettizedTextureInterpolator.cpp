@@ -0,0 +1,134 @@
+#include "Engine/Graphics/Rendering/InterpolationContext.h"
+#include "Engine/Graphics/Interpolators/PalettizedTextureInterpolator.h"
+
+namespace Volition
+{
+
+static void StartFun(VPalettizedTextureInterpolator* Self)
+{
+    const VInterpolationContext* InterpolationContext = Self->InterpolationContext;
+    const VTexture& Texture = InterpolationContext->Material->Texture;
+
+    const VSurface* Surface = &Texture.Get(InterpolationContext->MipMappingLevel);
+    VLN_ASSERT(Surface);
+
+    Self->TextureBuffer = Texture.GetIndexed(InterpolationContext->MipMappingLevel);
+    Self->TexturePitch = Surface->GetWidth();
+    const VVector2 TextureSize = { (f32)Surface->GetWidth(), (f32)Surface->GetHeight() };
+
+    // Polygon gets one light level, so shading is folded into palette
+    VColorARGB LitColor;
+    if (InterpolationContext->MaterialAttr & EMaterialAttr::ShadeModeGouraud)
+    {
+        LitColor = MAP_XRGB32(
+            (InterpolationContext->LitColor[0].R + InterpolationContext->LitColor[1].R + InterpolationContext->LitColor[2].R) / 3,
+            (InterpolationContext->LitColor[0].G + InterpolationContext->LitColor[1].G + InterpolationContext->LitColor[2].G) / 3,
+            (InterpolationContext->LitColor[0].B + InterpolationContext->LitColor[1].B + InterpolationContext->LitColor[2].B) / 3
+        );
+    }
+    else if (InterpolationContext->MaterialAttr & EMaterialAttr::ShadeModeFlat)
+    {
+        LitColor = InterpolationContext->LitColor[0];
+    }
+    else
+    {
+        LitColor = InterpolationContext->OriginalColor;
+    }
+
+    Self->Palette = Texture.GetLitPalette(LitColor);
+
+    for (i32f i = 0; i < 3; ++i)
+    {
+        Self->UVtx[i] = FloatToFx16((InterpolationContext->Vtx[i].U * TextureSize.X));
+        Self->VVtx[i] = FloatToFx16((InterpolationContext->Vtx[i].V * TextureSize.Y));
+    }
+}
+
+static void ComputeYStartsAndDeltasLeftFun(VPalettizedTextureInterpolator* Self, i32 YDiffLeft, i32 LeftStartVtx, i32 LeftEndVtx)
+{
+    Self->ULeft = Self->UVtx[LeftStartVtx];
+    Self->VLeft = Self->VVtx[LeftStartVtx];
+
+    Self->UDeltaLeftByY = (Self->UVtx[LeftEndVtx] - Self->UVtx[LeftStartVtx]) / YDiffLeft;
+    Self->VDeltaLeftByY = (Self->VVtx[LeftEndVtx] - Self->VVtx[LeftStartVtx]) / YDiffLeft;
+}
+
+static void ComputeYStartsAndDeltasRightFun(VPalettizedTextureInterpolator* Self, i32 YDiffRight, i32 RightStartVtx, i32 RightEndVtx)
+{
+    Self->URight = Self->UVtx[RightStartVtx];
+    Self->VRight = Self->VVtx[RightStartVtx];
+
+    Self->UDeltaRightByY = (Self->UVtx[RightEndVtx] - Self->UVtx[RightStartVtx]) / YDiffRight;
+    Self->VDeltaRightByY = (Self->VVtx[RightEndVtx] - Self->VVtx[RightStartVtx]) / YDiffRight;
+}
+
+static void SwapLeftRightFun(VPalettizedTextureInterpolator* Self)
+{
+    i32 TempInt;
+
+    VLN_SWAP(Self->UDeltaLeftByY, Self->UDeltaRightByY, TempInt);
+    VLN_SWAP(Self->VDeltaLeftByY, Self->VDeltaRightByY, TempInt);
+
+    VLN_SWAP(Self->ULeft, Self->URight, TempInt);
+    VLN_SWAP(Self->VLeft, Self->VRight, TempInt);
+
+    VLN_SWAP(Self->UVtx[Self->InterpolationContext->VtxIndices[1]], Self->UVtx[Self->InterpolationContext->VtxIndices[2]], TempInt);
+    VLN_SWAP(Self->VVtx[Self->InterpolationContext->VtxIndices[1]], Self->VVtx[Self->InterpolationContext->VtxIndices[2]], TempInt);
+}
+
+static void ComputeXStartsAndDeltasFun(VPalettizedTextureInterpolator* Self, i32 XDiff, fx28 ZLeft, fx28 ZRight)
+{
+    Self->U = Self->ULeft;
+    Self->V = Self->VLeft;
+
+    if (XDiff > 0)
+    {
+        Self->UDeltaByX = (Self->URight - Self->ULeft) / XDiff;
+        Self->VDeltaByX = (Self->VRight - Self->VLeft) / XDiff;
+    }
+    else
+    {
+        Self->UDeltaByX = (Self->URight - Self->ULeft);
+        Self->VDeltaByX = (Self->VRight - Self->VLeft);
+    }
+}
+
+static void ProcessPixelFun(VPalettizedTextureInterpolator* Self)
+{
+    Self->InterpolationContext->Pixel = Self->Palette[
+        Self->TextureBuffer[Fx16ToInt(Self->V) * Self->TexturePitch + Fx16ToInt(Self->U)]
+    ];
+}
+
+static void InterpolateXFun(VPalettizedTextureInterpolator* Self, i32 X)
+{
+    Self->U += Self->UDeltaByX * X;
+    Self->V += Self->VDeltaByX * X;
+}
+
+static void InterpolateYLeftFun(VPalettizedTextureInterpolator* Self, i32 YLeft)
+{
+    Self->ULeft += Self->UDeltaLeftByY * YLeft;
+    Self->VLeft += Self->VDeltaLeftByY * YLeft;
+}
+
+static void InterpolateYRightFun(VPalettizedTextureInterpolator* Self, i32 YRight)
+{
+    Self->URight += Self->UDeltaRightByY * YRight;
+    Self->VRight += Self->VDeltaRightByY * YRight;
+}
+
+VPalettizedTextureInterpolator::VPalettizedTextureInterpolator()
+{
+    Start = (StartType)StartFun;
+    ComputeYStartsAndDeltasLeft = (ComputeYStartsAndDeltasLeftType)ComputeYStartsAndDeltasLeftFun;
+    ComputeYStartsAndDeltasRight = (ComputeYStartsAndDeltasRightType)ComputeYStartsAndDeltasRightFun;
+    SwapLeftRight = (SwapLeftRightType)SwapLeftRightFun;
+    ComputeXStartsAndDeltas = (ComputeXStartsAndDeltasType)ComputeXStartsAndDeltasFun;
+    ProcessPixel = (ProcessPixelType)ProcessPixelFun;
+    InterpolateX = (InterpolateXType)InterpolateXFun;
+    InterpolateYLeft = (InterpolateYLeftType)InterpolateYLeftFun;
+    InterpolateYRight = (InterpolateYRightType)InterpolateYRightFun;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Engine/Graphics/Interpolators/IInterpolator.h"
+#include "Common/Math/Fixed16.h"
+
+namespace Volition
+{
+
+/** Affine mapping of 8-bit texels through lit palette, also does shading */
+class VPalettizedTextureInterpolator : public IInterpolator
+{
+public:
+    fx16 UVtx[3], VVtx[3];
+
+    fx16 U, V;
+
+    fx16 ULeft, VLeft;
+    fx16 URight, VRight;
+
+    fx16 UDeltaLeftByY, VDeltaLeftByY;
+    fx16 UDeltaRightByY, VDeltaRightByY;
+
+    fx16 UDeltaByX, VDeltaByX;
+
+    const u8* TextureBuffer;
+    i32 TexturePitch;
+
+    const VColorARGB* Palette;
+
+public:
+    VPalettizedTextureInterpolator();
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <xmmintrin.h>
+#include "Common/Math/Math.h"
+#include "Common/Platform/Assert.h"
+#include "Engine/Graphics/Rendering/DepthRasterizer.h"
+
+namespace Volition
+{
+
+b32 VDepthRasterizer::RasterizeTriangle(
+    f32* Buffer, i32 Width, i32 Height,
+    const VVector3 P[3],
+    u32 FullCoverageEdges,
+    b32 bConservativeDepth,
+    VDepthRasterBounds& OutBounds
+)
+{
+    VLN_ASSERT((Width & 3) == 0);
+
+    f32 X[3] = { P[0].X, P[1].X, P[2].X };
+    f32 Y[3] = { P[0].Y, P[1].Y, P[2].Y };
+    f32 Z[3] = { P[0].Z, P[1].Z, P[2].Z };
+
+    f32 Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+
+    // Make edge functions positive inside
+    if (Area < 0.0f)
+    {
+        f32 Temp;
+        VLN_SWAP(X[1], X[2], Temp);
+        VLN_SWAP(Y[1], Y[2], Temp);
+        VLN_SWAP(Z[1], Z[2], Temp);
+        Area = -Area;
+
+        // Edges 0 and 2 swap with vertices
+        FullCoverageEdges = (FullCoverageEdges & 2) | ((FullCoverageEdges & 1) << 2) | ((FullCoverageEdges & 4) >> 2);
+    }
+
+    if (Area < Math.Epsilon5)
+    {
+        return false;
+    }
+
+    // Bounding box
+    const f32 XMin = VLN_MIN(X[0], VLN_MIN(X[1], X[2]));
+    const f32 XMax = VLN_MAX(X[0], VLN_MAX(X[1], X[2]));
+    const f32 YMin = VLN_MIN(Y[0], VLN_MIN(Y[1], Y[2]));
+    const f32 YMax = VLN_MAX(Y[0], VLN_MAX(Y[1], Y[2]));
+
+    if (XMax < 0.0f || YMax < 0.0f || XMin >= (f32)Width || YMin >= (f32)Height)
+    {
+        return false;
+    }
+
+    // Only pixels which centers are inside of bounding box, small triangles often have none. Max is not negative here
+    const i32 FirstX = VLN_MAX((i32)(XMin + 0.5f), 0);
+    const i32 X1 = VLN_MIN((i32)(XMax + 0.5f) - 1, Width - 1);
+    const i32 Y0 = VLN_MAX((i32)(YMin + 0.5f), 0);
+    const i32 Y1 = VLN_MIN((i32)(YMax + 0.5f) - 1, Height - 1);
+
+    if (FirstX > X1 || Y0 > Y1)
+    {
+        return false;
+    }
+
+    const i32 X0 = FirstX & ~3; // Start at 4 pixel block
+
+    OutBounds = { X0, Y0, VLN_MIN(X1 | 3, Width - 1), Y1 };
+
+    /*
+        E = A * x + B * y + C for edge from Va to Vb.
+        Pixel is fully inside if E at its center is greater than half of |A| + |B|
+    */
+    f32 A[3], B[3], C[3];
+
+    for (i32f i = 0; i < 3; ++i)
+    {
+        const i32f a = i;
+        const i32f b = (i + 1) % 3;
+
+        A[i] = -(Y[b] - Y[a]);
+        B[i] = X[b] - X[a];
+        C[i] = -(A[i] * X[a] + B[i] * Y[a]);
+
+        if ((FullCoverageEdges >> i) & 1)
+        {
+            C[i] -= 0.5f * (Math.Abs(A[i]) + Math.Abs(B[i]));
+        }
+    }
+
+    // 1/depth plane, conservative one is taken at the furthest corner of pixel
+    const f32 InvArea = 1.0f / Area;
+    const f32 ZDX = ((Z[1] - Z[0]) * (Y[2] - Y[0]) - (Z[2] - Z[0]) * (Y[1] - Y[0])) * InvArea;
+    const f32 ZDY = ((Z[2] - Z[0]) * (X[1] - X[0]) - (Z[1] - Z[0]) * (X[2] - X[0])) * InvArea;
+
+    f32 ZC = Z[0] - ZDX * X[0] - ZDY * Y[0];
+    if (bConservativeDepth)
+    {
+        ZC -= 0.5f * (Math.Abs(ZDX) + Math.Abs(ZDY));
+    }
+
+    const __m128 PixelCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 Zero = _mm_setzero_ps();
+
+    __m128 EStep[3];
+    for (i32f i = 0; i < 3; ++i)
+    {
+        EStep[i] = _mm_set1_ps(A[i] * 4.0f);
+    }
+    const __m128 ZStep = _mm_set1_ps(ZDX * 4.0f);
+
+    const __m128 BlockX = _mm_add_ps(_mm_set1_ps((f32)X0), PixelCenters);
+
+    for (i32f PY = Y0; PY <= Y1; ++PY)
+    {
+        const f32 CenterY = (f32)PY + 0.5f;
+
+        __m128 E[3];
+        for (i32f i = 0; i < 3; ++i)
+        {
+            E[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[i]), BlockX), _mm_set1_ps(B[i] * CenterY + C[i]));
+        }
+        __m128 Depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ZDX), BlockX), _mm_set1_ps(ZDY * CenterY + ZC));
+
+        f32* Row = Buffer + PY * Width;
+
+        for (i32f PX = X0; PX <= X1; PX += 4)
+        {
+            const __m128 Mask = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(E[0], Zero), _mm_cmpge_ps(E[1], Zero)),
+                _mm_cmpge_ps(E[2], Zero)
+            );
+
+            if (_mm_movemask_ps(Mask))
+            {
+                const __m128 Old = _mm_loadu_ps(Row + PX);
+                const __m128 New = _mm_max_ps(Old, Depth);
+
+                _mm_storeu_ps(Row + PX, _mm_or_ps(_mm_and_ps(Mask, New), _mm_andnot_ps(Mask, Old)));
+            }
+
+            E[0] = _mm_add_ps(E[0], EStep[0]);
+            E[1] = _mm_add_ps(E[1], EStep[1]);
+            E[2] = _mm_add_ps(E[2], EStep[2]);
+            Depth = _mm_add_ps(Depth, ZStep);
+        }
+    }
+
+    return true;
+}
+
+}
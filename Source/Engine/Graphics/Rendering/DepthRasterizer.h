@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Math/Vector.h"
+#include "Common/Platform/Platform.h"
+
+namespace Volition
+{
+
+/** Pixels touched by rasterized triangle, inclusive */
+struct VDepthRasterBounds
+{
+    i32 X0, Y0;
+    i32 X1, Y1;
+};
+
+/**
+    Depth only rasterizer into row-major buffer of 1/depth which keeps max of it, 0 is empty.
+    Four pixels are tested and written at once with SSE, so buffer width has to be multiple of 4
+*/
+class VDepthRasterizer
+{
+public:
+    /**
+        Buffer space triangle with 1/depth in Z, pixel centers are sampled, both faces are drawn.
+        Edge from vertex N with bit (1 << N) of FullCoverageEdges set draws only pixels which it fully covers.
+        If bConservativeDepth, min of 1/depth over pixel is written instead of the one at its center.
+        Returns false if nothing was touched
+    */
+    static b32 RasterizeTriangle(
+        f32* Buffer, i32 Width, i32 Height,
+        const VVector3 P[3],
+        u32 FullCoverageEdges,
+        b32 bConservativeDepth,
+        VDepthRasterBounds& OutBounds
+    );
+};
+
+}
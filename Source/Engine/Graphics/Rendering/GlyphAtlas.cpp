@@ -0,0 +1,109 @@
+#include "Common/Platform/Assert.h"
+#include "Common/Platform/Memory.h"
+#include "Engine/Core/DebugLog.h"
+#include "Engine/Graphics/Rendering/GlyphAtlas.h"
+
+namespace Volition
+{
+
+VLN_DEFINE_LOG_CHANNEL(hLogGlyphAtlas, "GlyphAtlas");
+
+void VGlyphAtlas::Build(TTF_Font* Font, i32 InCellWidth, i32 InCellHeight)
+{
+    VLN_ASSERT(Font);
+
+    CellWidth = VLN_MAX(InCellWidth, 1);
+    CellHeight = VLN_MAX(InCellHeight, 1);
+
+    const i32 CellSize = CellWidth * CellHeight;
+    Masks.Resize(NumGlyphs * CellSize);
+    Memory.MemSetByte(Masks.GetData(), 0, NumGlyphs * CellSize);
+
+    static constexpr SDL_Color White = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+    for (i32f Char = FirstChar; Char <= LastChar; ++Char)
+    {
+        // Solid glyphs are 8-bit, 0 is background index
+        SDL_Surface* Glyph = TTF_RenderGlyph_Solid(Font, (u16)Char, White);
+        if (!Glyph)
+        {
+            VLN_WARNING(hLogGlyphAtlas, "Can't render glyph '%c'\n", (char)Char);
+            continue;
+        }
+
+        u8* Mask = Masks.GetData() + (Char - FirstChar) * CellSize;
+        const u8* Pixels = (const u8*)Glyph->pixels;
+
+        // Nearest sampling, same as scaled blit of rendered line we had before
+        for (i32f Y = 0; Y < CellHeight; ++Y)
+        {
+            const u8* SourceRow = Pixels + (Y * Glyph->h / CellHeight) * Glyph->pitch;
+
+            for (i32f X = 0; X < CellWidth; ++X)
+            {
+                Mask[X] = SourceRow[X * Glyph->w / CellWidth] ? 0xFF : 0x00;
+            }
+
+            Mask += CellWidth;
+        }
+
+        SDL_FreeSurface(Glyph);
+    }
+}
+
+void VGlyphAtlas::Destroy()
+{
+    Masks.Clear();
+    CellWidth = 0;
+    CellHeight = 0;
+}
+
+void VGlyphAtlas::DrawText(u32* Buffer, i32 Pitch, i32 Width, i32 Height, i32 X, i32 Y, const char* Text, u32 Color) const
+{
+    if (!Masks.GetLength())
+    {
+        return;
+    }
+
+    // Vertical clipping is the same for whole line
+    const i32 YStart = VLN_MAX(Y, 0) - Y;
+    const i32 YEnd = VLN_MIN(Y + CellHeight, Height) - Y;
+    if (YStart >= YEnd)
+    {
+        return;
+    }
+
+    for (const char* Char = Text; *Char; ++Char, X += CellWidth)
+    {
+        if (X >= Width)
+        {
+            break;
+        }
+        if (X + CellWidth <= 0 || *Char < FirstChar || *Char > LastChar || *Char == ' ')
+        {
+            continue;
+        }
+
+        const i32 XStart = VLN_MAX(X, 0) - X;
+        const i32 XEnd = VLN_MIN(X + CellWidth, Width) - X;
+
+        const u8* MaskRow = GetGlyph(*Char) + YStart * CellWidth;
+        u32* DestRow = Buffer + (Y + YStart) * Pitch + X;
+
+        for (i32f CellY = YStart; CellY < YEnd; ++CellY)
+        {
+            for (i32f CellX = XStart; CellX < XEnd; ++CellX)
+            {
+                if (MaskRow[CellX])
+                {
+                    DestRow[CellX] = Color;
+                }
+            }
+
+            MaskRow += CellWidth;
+            DestRow += Pitch;
+        }
+    }
+}
+
+}
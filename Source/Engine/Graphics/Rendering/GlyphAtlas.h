@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SDL_ttf.h"
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Platform/Platform.h"
+
+namespace Volition
+{
+
+/** Printable ASCII rasterized once into fixed size cells, text is drawn by copying cells into buffer */
+class VGlyphAtlas
+{
+public:
+    static constexpr i32f FirstChar = 32;
+    static constexpr i32f LastChar  = 126;
+    static constexpr i32f NumGlyphs = LastChar - FirstChar + 1;
+
+private:
+    /** One byte per cell pixel, non zero where glyph is, cells go one after another */
+    TArray<u8> Masks;
+
+    i32 CellWidth = 0;
+    i32 CellHeight = 0;
+
+public:
+    void Build(TTF_Font* Font, i32 InCellWidth, i32 InCellHeight);
+    void Destroy();
+
+    /** Clips against [0, Width) x [0, Height) */
+    void DrawText(u32* Buffer, i32 Pitch, i32 Width, i32 Height, i32 X, i32 Y, const char* Text, u32 Color) const;
+
+private:
+    VLN_FINLINE const u8* GetGlyph(i32 Char) const
+    {
+        return Masks.GetData() + (Char - FirstChar) * CellWidth * CellHeight;
+    }
+};
+
+}
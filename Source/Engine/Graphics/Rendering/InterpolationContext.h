@@ -13,7 +13,7 @@
 #include "Engine/Graphics/Interpolators/LinearPiecewiseTextureInterpolator.h"
 #include "Engine/Graphics/Interpolators/PerspectiveCorrectTextureInterpolator.h"
 #include "Engine/Graphics/Interpolators/BilinearPerspectiveTextureInterpolator.h"
-#include "Engine/Graphics/Interpolators/AlphaInterpolator.h"
+#include "Engine/Graphics/Interpolators/PalettizedTextureInterpolator.h"
 
 namespace Volition
 {
@@ -54,7 +54,7 @@ public:
     VLinearPiecewiseTextureInterpolator LinearPiecewiseTextureInterpolator;
     VPerspectiveCorrectTextureInterpolator PerspectiveCorrectTextureInterpolator;
     VBilinearPerspectiveTextureInterpolator BilinearPerspectiveTextureInterpolator;
-    VAlphaInterpolator AlphaInterpolator;
+    VPalettizedTextureInterpolator PalettizedTextureInterpolator;
 };
 
 }
\ No newline at end of file
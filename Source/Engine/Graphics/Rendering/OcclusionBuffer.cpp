@@ -0,0 +1,288 @@
+#include "Common/Math/Math.h"
+#include "Common/Platform/Memory.h"
+#include "Engine/Graphics/Rendering/DepthRasterizer.h"
+#include "Engine/Graphics/Rendering/OcclusionBuffer.h"
+
+namespace Volition
+{
+
+void VOcclusionBuffer::SetTerrainOccluder(const VVertex* VtxList, i32 VerticesInRow)
+{
+    const i32f NumCells = VerticesInRow - 1;
+    const i32f NumOccluderCells = (NumCells + OccluderGridStep - 1) / OccluderGridStep;
+
+    OccluderVerticesInRow = NumOccluderCells + 1;
+    OccluderVtx.Resize(OccluderVerticesInRow * OccluderVerticesInRow);
+    TransOccluderVtx.Resize(OccluderVtx.GetLength());
+    FrontFaces.Resize(NumOccluderCells * NumOccluderCells * 2);
+
+    for (i32f Y = 0; Y < OccluderVerticesInRow; ++Y)
+    {
+        for (i32f X = 0; X < OccluderVerticesInRow; ++X)
+        {
+            const i32f TerrainX = VLN_MIN(X * OccluderGridStep, NumCells);
+            const i32f TerrainY = VLN_MIN(Y * OccluderGridStep, NumCells);
+
+            // Min height over all terrain vertices of adjacent occluder cells
+            const i32f XBegin = VLN_MAX(TerrainX - OccluderGridStep, 0);
+            const i32f XEnd = VLN_MIN(TerrainX + OccluderGridStep, NumCells);
+            const i32f YBegin = VLN_MAX(TerrainY - OccluderGridStep, 0);
+            const i32f YEnd = VLN_MIN(TerrainY + OccluderGridStep, NumCells);
+
+            f32 MinHeight = VtxList[TerrainY * VerticesInRow + TerrainX].Y;
+
+            for (i32f TY = YBegin; TY <= YEnd; ++TY)
+            {
+                for (i32f TX = XBegin; TX <= XEnd; ++TX)
+                {
+                    MinHeight = VLN_MIN(MinHeight, VtxList[TY * VerticesInRow + TX].Y);
+                }
+            }
+
+            VVector4& Vtx = OccluderVtx[Y * OccluderVerticesInRow + X];
+            Vtx = VtxList[TerrainY * VerticesInRow + TerrainX].Position;
+            Vtx.Y = MinHeight;
+            Vtx.W = 1.0f;
+        }
+    }
+}
+
+void VOcclusionBuffer::RemoveOccluders()
+{
+    OccluderVtx.Clear();
+    TransOccluderVtx.Clear();
+    FrontFaces.Clear();
+    OccluderVerticesInRow = 0;
+    bRendered = false;
+}
+
+void VOcclusionBuffer::Render(const VCamera& Camera)
+{
+    Memory.MemSetQuad(Buffer, 0, Width * Height);
+
+    MatCamera = Camera.MatCamera;
+    XScale = (f32)Width * 0.5f * Camera.ViewDist;
+    YScale = (f32)Height * 0.5f * Camera.ViewDist * Camera.AspectRatio;
+    ZNearClip = Camera.ZNearClip;
+
+    for (VSizeType i = 0; i < OccluderVtx.GetLength(); ++i)
+    {
+        VMatrix44::MulVecMat(OccluderVtx[i], MatCamera, TransOccluderVtx[i]);
+    }
+
+    // Front facing flags to find silhouette edges, triangulation is the same as terrain
+    const i32f NumCellsInRow = OccluderVerticesInRow - 1;
+
+    for (i32f Y = 0; Y < NumCellsInRow; ++Y)
+    {
+        for (i32f X = 0; X < NumCellsInRow; ++X)
+        {
+            const VVector4& V00 = TransOccluderVtx[Y * OccluderVerticesInRow + X];
+            const VVector4& V01 = TransOccluderVtx[Y * OccluderVerticesInRow + X + 1];
+            const VVector4& V10 = TransOccluderVtx[(Y + 1) * OccluderVerticesInRow + X];
+            const VVector4& V11 = TransOccluderVtx[(Y + 1) * OccluderVerticesInRow + X + 1];
+
+            // Camera is at origin
+            VVector4 Normal;
+            VVector4::Cross(V10 - V00, V11 - V00, Normal);
+            FrontFaces[(Y * NumCellsInRow + X) * 2] = VVector4::Dot(V00, Normal) < 0.0f;
+
+            VVector4::Cross(V11 - V00, V01 - V00, Normal);
+            FrontFaces[(Y * NumCellsInRow + X) * 2 + 1] = VVector4::Dot(V00, Normal) < 0.0f;
+        }
+    }
+
+    const auto IsFrontFace = [this, NumCellsInRow](i32f X, i32f Y, i32f Triangle) -> b32
+    {
+        return X >= 0 && Y >= 0 && X < NumCellsInRow && Y < NumCellsInRow && FrontFaces[(Y * NumCellsInRow + X) * 2 + Triangle];
+    };
+
+    for (i32f Y = 0; Y < NumCellsInRow; ++Y)
+    {
+        for (i32f X = 0; X < NumCellsInRow; ++X)
+        {
+            const VVector4& V00 = TransOccluderVtx[Y * OccluderVerticesInRow + X];
+            const VVector4& V01 = TransOccluderVtx[Y * OccluderVerticesInRow + X + 1];
+            const VVector4& V10 = TransOccluderVtx[(Y + 1) * OccluderVerticesInRow + X];
+            const VVector4& V11 = TransOccluderVtx[(Y + 1) * OccluderVerticesInRow + X + 1];
+
+            // V00 V10 V11, neighbours over edges are left cell, upper cell and other half of this cell
+            if (IsFrontFace(X, Y, 0))
+            {
+                const u32 SilhouetteEdges =
+                    (IsFrontFace(X - 1, Y, 1) ? 0 : 1) |
+                    (IsFrontFace(X, Y + 1, 1) ? 0 : 2) |
+                    (IsFrontFace(X, Y, 1)     ? 0 : 4);
+
+                DrawTriangle(V00, V10, V11, SilhouetteEdges);
+            }
+
+            // V00 V11 V01, neighbours are other half of this cell, right cell and lower cell
+            if (IsFrontFace(X, Y, 1))
+            {
+                const u32 SilhouetteEdges =
+                    (IsFrontFace(X, Y, 0)     ? 0 : 1) |
+                    (IsFrontFace(X + 1, Y, 0) ? 0 : 2) |
+                    (IsFrontFace(X, Y - 1, 0) ? 0 : 4);
+
+                DrawTriangle(V00, V11, V01, SilhouetteEdges);
+            }
+        }
+    }
+
+    bRendered = true;
+}
+
+b32 VOcclusionBuffer::IsOccluded(const VVector3& Min, const VVector3& Max) const
+{
+    if (!bRendered)
+    {
+        return false;
+    }
+
+    // Sphere around box in camera space
+    const VVector4 Center = {
+        (Min.X + Max.X) * 0.5f,
+        (Min.Y + Max.Y) * 0.5f,
+        (Min.Z + Max.Z) * 0.5f,
+        1.0f
+    };
+    const VVector4 Extents = {
+        (Max.X - Min.X) * 0.5f,
+        (Max.Y - Min.Y) * 0.5f,
+        (Max.Z - Min.Z) * 0.5f,
+        0.0f
+    };
+    const f32 Radius = Extents.GetLength();
+
+    VVector4 Pos;
+    VMatrix44::MulVecMat(Center, MatCamera, Pos);
+
+    const f32 NearZ = Pos.Z - Radius;
+    const f32 FarZ = Pos.Z + Radius;
+
+    if (NearZ <= ZNearClip)
+    {
+        return false;
+    }
+
+    // Projection of box around sphere, extremes of X/Z and Y/Z are at its near or far side
+    const f32 XMin = (Pos.X - Radius) / (Pos.X - Radius < 0.0f ? NearZ : FarZ);
+    const f32 XMax = (Pos.X + Radius) / (Pos.X + Radius > 0.0f ? NearZ : FarZ);
+    const f32 YMin = (Pos.Y - Radius) / (Pos.Y - Radius < 0.0f ? NearZ : FarZ);
+    const f32 YMax = (Pos.Y + Radius) / (Pos.Y + Radius > 0.0f ? NearZ : FarZ);
+
+    i32 X0 = (i32)Math.Floor((f32)Width * 0.5f + XScale * XMin);
+    i32 X1 = (i32)Math.Floor((f32)Width * 0.5f + XScale * XMax);
+    i32 Y0 = (i32)Math.Floor((f32)Height * 0.5f - YScale * YMax);
+    i32 Y1 = (i32)Math.Floor((f32)Height * 0.5f - YScale * YMin);
+
+    X0 = VLN_MAX(X0, 0);
+    Y0 = VLN_MAX(Y0, 0);
+    X1 = VLN_MIN(X1, (i32)Width - 1);
+    Y1 = VLN_MIN(Y1, (i32)Height - 1);
+
+    if (X0 > X1 || Y0 > Y1)
+    {
+        return false;
+    }
+
+    // Hidden only if every pixel has closer occluder than nearest point of bounds
+    const f32 NearInvZ = 1.0f / NearZ;
+
+    for (i32f Y = Y0; Y <= Y1; ++Y)
+    {
+        const f32* Row = Buffer + Y * Width;
+
+        for (i32f X = X0; X <= X1; ++X)
+        {
+            if (Row[X] <= NearInvZ)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void VOcclusionBuffer::DrawTriangle(const VVector4& V0, const VVector4& V1, const VVector4& V2, u32 SilhouetteEdges)
+{
+    const VVector4* Vtx[3] = { &V0, &V1, &V2 };
+
+    // Clip by near plane, cut edge is silhouette since the rest of triangle is not drawn
+    VVector4 Clipped[4];
+    u32 ClippedEdges = 0;
+    i32f NumClipped = 0;
+
+    for (i32f i = 0; i < 3; ++i)
+    {
+        const VVector4& Current = *Vtx[i];
+        const VVector4& Next = *Vtx[(i + 1) % 3];
+        const u32 EdgeFlag = (SilhouetteEdges >> i) & 1;
+
+        const b32 bCurrentIn = Current.Z >= ZNearClip;
+        const b32 bNextIn = Next.Z >= ZNearClip;
+
+        if (bCurrentIn)
+        {
+            ClippedEdges |= EdgeFlag << NumClipped;
+            Clipped[NumClipped++] = Current;
+        }
+
+        if (bCurrentIn != bNextIn)
+        {
+            const f32 T = (ZNearClip - Current.Z) / (Next.Z - Current.Z);
+
+            VVector4& NewVtx = Clipped[NumClipped];
+            NewVtx.X = Current.X + (Next.X - Current.X) * T;
+            NewVtx.Y = Current.Y + (Next.Y - Current.Y) * T;
+            NewVtx.Z = ZNearClip;
+            NewVtx.W = 1.0f;
+
+            ClippedEdges |= (bCurrentIn ? 1 : EdgeFlag) << NumClipped;
+            ++NumClipped;
+        }
+    }
+
+    if (NumClipped < 3)
+    {
+        return;
+    }
+
+    // Project to buffer, Z becomes 1/z
+    VVector3 Projected[4];
+
+    for (i32f i = 0; i < NumClipped; ++i)
+    {
+        const f32 InvZ = 1.0f / Clipped[i].Z;
+
+        Projected[i].X = (f32)Width * 0.5f + XScale * Clipped[i].X * InvZ;
+        Projected[i].Y = (f32)Height * 0.5f - YScale * Clipped[i].Y * InvZ;
+        Projected[i].Z = InvZ;
+    }
+
+    // Fan, diagonal of quad is inner edge
+    if (NumClipped == 3)
+    {
+        RasterizeTriangle(Projected, ClippedEdges);
+    }
+    else
+    {
+        VVector3 Triangle[3] = { Projected[0], Projected[1], Projected[2] };
+        RasterizeTriangle(Triangle, ClippedEdges & (1 | 2));
+
+        Triangle[1] = Projected[2];
+        Triangle[2] = Projected[3];
+        RasterizeTriangle(Triangle, (ClippedEdges >> 1) & (2 | 4));
+    }
+}
+
+void VOcclusionBuffer::RasterizeTriangle(const VVector3 P[3], u32 SilhouetteEdges)
+{
+    // Inner edges are covered by neighbours, and occluder is never closer than it is
+    VDepthRasterBounds Bounds;
+    VDepthRasterizer::RasterizeTriangle(Buffer, Width, Height, P, SilhouetteEdges, true, Bounds);
+}
+
+}
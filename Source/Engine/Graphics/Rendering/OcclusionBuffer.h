@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Math/Vector.h"
+#include "Common/Platform/Platform.h"
+#include "Engine/Graphics/Types/Vertex.h"
+#include "Engine/Graphics/Scene/Camera.h"
+
+namespace Volition
+{
+
+/**
+    Low resolution 1/z buffer with conservative occluders.
+    Occluders are only drawn where they fully cover a pixel and never closer than they are,
+    so bounds tested as hidden are really hidden
+*/
+class VOcclusionBuffer
+{
+public:
+    static constexpr i32f Width = 256;
+    static constexpr i32f Height = 128;
+
+    /** Terrain cells merged into one occluder cell */
+    static constexpr i32f OccluderGridStep = 8;
+
+private:
+    f32 Buffer[Width * Height]; /** 1/z, 0 is empty */
+
+    /** Terrain lowered to min height around each vertex, so it never sticks out of real one */
+    TArray<VVector4> OccluderVtx;
+    TArray<VVector4> TransOccluderVtx;
+    TArray<u8> FrontFaces; /** Two triangles per cell */
+    i32 OccluderVerticesInRow = 0;
+
+    /** Camera to buffer mapping of last Render() */
+    VMatrix44 MatCamera;
+    f32 XScale = 0.0f, YScale = 0.0f;
+    f32 ZNearClip = 0.0f;
+
+    b32 bRendered = false;
+
+public:
+    /** World space vertices of terrain grid, VerticesInRow x VerticesInRow */
+    void SetTerrainOccluder(const VVertex* VtxList, i32 VerticesInRow);
+    void RemoveOccluders();
+
+    /** Clears buffer and rasterizes occluders from camera */
+    void Render(const VCamera& Camera);
+
+    /** True if world space box is behind occluders of last Render() */
+    b32 IsOccluded(const VVector3& Min, const VVector3& Max) const;
+
+    VLN_FINLINE b32 HasOccluders() const
+    {
+        return OccluderVerticesInRow > 0;
+    }
+
+private:
+    /** Camera space triangle, bit (1 << N) of SilhouetteEdges is set if edge from vertex N has no front facing neighbour */
+    void DrawTriangle(const VVector4& V0, const VVector4& V1, const VVector4& V2, u32 SilhouetteEdges);
+
+    /** Buffer space triangle with 1/z in Z. Pixel centers are sampled, but only fully covered pixels near silhouette */
+    void RasterizeTriangle(const VVector3 P[3], u32 SilhouetteEdges);
+};
+
+}
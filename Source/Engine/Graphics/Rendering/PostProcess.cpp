@@ -0,0 +1,85 @@
+#include "Common/Platform/Assert.h"
+#include "Engine/Core/Config/Config.h"
+#include "Engine/Core/JobSystem.h"
+#include "Engine/Graphics/Rendering/PostProcess.h"
+
+namespace Volition
+{
+
+b32 VColorCorrectionPass::Prepare(const VPostProcessSettings& Settings)
+{
+    const VVector3& Correction = Settings.ColorCorrection;
+
+    if (Correction == VRenderSpecification::DefaultColorCorrection)
+    {
+        return false;
+    }
+
+    // Tables are rebuilt only when correction changes
+    if (Correction != LUT.GetCorrection())
+    {
+        LUT.Build(Correction);
+    }
+
+    return true;
+}
+
+void VColorCorrectionPass::ProcessRows(u32* Buffer, i32 Pitch, i32 Width, i32 YBegin, i32 YEnd) const
+{
+    Buffer += YBegin * Pitch;
+
+    for (i32f Y = YBegin; Y < YEnd; ++Y)
+    {
+        LUT.ApplyRow(Buffer, Width);
+        Buffer += Pitch;
+    }
+}
+
+void VPostProcessChain::AddPass(IPostProcessPass* Pass)
+{
+    VLN_ASSERT(Pass);
+    VLN_ASSERT(Passes.GetLength() < MaxPasses);
+
+    Passes.EmplaceBack(Pass);
+}
+
+void VPostProcessChain::Clear()
+{
+    Passes.Clear();
+}
+
+void VPostProcessChain::Process(VSurface& Surface, i32 Width, i32 Height, const VPostProcessSettings& Settings)
+{
+    const IPostProcessPass* ActivePasses[MaxPasses];
+    i32 NumActivePasses = 0;
+
+    for (IPostProcessPass* Pass : Passes)
+    {
+        if (Pass->Prepare(Settings))
+        {
+            ActivePasses[NumActivePasses++] = Pass;
+        }
+    }
+
+    if (!NumActivePasses)
+    {
+        return;
+    }
+
+    u32* Buffer;
+    i32 Pitch;
+    Surface.Lock(Buffer, Pitch);
+
+    static constexpr i32f MinBandHeight = 16;
+    JobSystem.ParallelFor(Height, MinBandHeight, [&](i32 Begin, i32 End)
+    {
+        for (i32f i = 0; i < NumActivePasses; ++i)
+        {
+            ActivePasses[i]->ProcessRows(Buffer, Pitch, Width, Begin, End);
+        }
+    });
+
+    Surface.Unlock();
+}
+
+}
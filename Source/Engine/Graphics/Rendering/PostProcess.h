@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Platform/Platform.h"
+#include "Engine/Graphics/Types/ColorLUT.h"
+#include "Engine/Graphics/Rendering/Surface.h"
+
+namespace Volition
+{
+
+/** Values read by passes, copied from render specification when frame is submitted */
+struct VPostProcessSettings
+{
+    VVector3 ColorCorrection;
+};
+
+/** Full screen pass which works on independent bands of rows */
+class IPostProcessPass
+{
+public:
+    virtual ~IPostProcessPass() = default;
+
+    /** Called once per frame on thread which presents it, returns false if pass has nothing to do */
+    virtual b32 Prepare(const VPostProcessSettings& Settings) = 0;
+
+    /** Called from job threads, bands never overlap */
+    virtual void ProcessRows(u32* Buffer, i32 Pitch, i32 Width, i32 YBegin, i32 YEnd) const = 0;
+};
+
+class VColorCorrectionPass : public IPostProcessPass
+{
+    VColorLUT LUT;
+
+public:
+    virtual b32 Prepare(const VPostProcessSettings& Settings) override;
+    virtual void ProcessRows(u32* Buffer, i32 Pitch, i32 Width, i32 YBegin, i32 YEnd) const override;
+};
+
+/** Runs all active passes band by band, so every band is still in cache for the next pass */
+class VPostProcessChain
+{
+public:
+    static constexpr i32f MaxPasses = 8;
+
+private:
+    TArray<IPostProcessPass*> Passes;
+
+public:
+    void AddPass(IPostProcessPass* Pass);
+    void Clear();
+
+    /** Processes top left Width x Height part of surface */
+    void Process(VSurface& Surface, i32 Width, i32 Height, const VPostProcessSettings& Settings);
+};
+
+}
@@ -1,69 +1,213 @@
+#include <algorithm>
 #include "Engine/Graphics/Rendering/Renderer.h"
 #include "Engine/Graphics/Rendering/RenderList.h"
 
 namespace Volition
 {
 
-b32 VRenderList::InsertPoly(const VPoly& Poly, const VVertex* VtxList, const VPoint2* TextureCoordsList, const VMaterial* Material)
+VRenderList::~VRenderList()
 {
-    if (NumPoly >= MaxPoly)
+    for (VPolyFace* Chunk : PolyChunks)
     {
-        return false;
+        delete[] Chunk;
     }
+}
 
-    VPolyFace& PolyFace = PolyList[NumPoly];
+void VRenderList::Reserve(i32 InNumPoly)
+{
+    while (GetCapacity() < InNumPoly)
+    {
+        PolyChunks.EmplaceBack(new VPolyFace[PolyChunkSize]);
+        ++NumGrownChunks;
+    }
+}
 
+b32 VRenderList::InsertPoly(const VPoly& Poly, const VVertex* VtxList, const VPoint2* TextureCoordsList, const VMaterial* Material)
+{
+    Reserve(NumPoly + 1);
+
+    SetPolyFace(GetPoly(NumPoly), Poly, VtxList, TextureCoordsList, Material);
+    AppendActivePoly(NumPoly);
+
+    ++NumPoly;
+    return true;
+}
+
+void VRenderList::SetPolyFace(VPolyFace& PolyFace, const VPoly& Poly, const VVertex* VtxList, const VPoint2* TextureCoordsList, const VMaterial* Material)
+{
     PolyFace.State = Poly.State;
     PolyFace.Material = Material;
     PolyFace.NormalLength = Poly.NormalLength;
 
     for (i32f i = 0; i < 3; ++i)
     {
-        PolyFace.TransVtx[i] = PolyFace.LocalVtx[i] = VtxList[Poly.VtxIndices[i]];
-        PolyFace.TransVtx[i].TextureCoords = PolyFace.LocalVtx[i].TextureCoords = TextureCoordsList[Poly.TextureCoordsIndices[i]];
+        PolyFace.TransVtx[i] = VtxList[Poly.VtxIndices[i]];
+        PolyFace.TransVtx[i].TextureCoords = TextureCoordsList[Poly.TextureCoordsIndices[i]];
+
+        PolyFace.LocalVtx[i].Position = PolyFace.TransVtx[i].Position;
+        PolyFace.LocalVtx[i].Normal = PolyFace.TransVtx[i].Normal;
 
         PolyFace.LitColor[i] = Poly.LitColor[i];
     }
+}
+
+b32 VRenderList::InsertPolyFace(const VPolyFace& Poly)
+{
+    Reserve(NumPoly + 1);
+
+    GetPoly(NumPoly) = Poly;
+    AppendActivePoly(NumPoly);
 
     ++NumPoly;
+
     return true;
 }
 
-b32 VRenderList::InsertPolyFace(const VPolyFace& Poly)
+void VRenderList::InsertMesh(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial, b32 bClusters)
 {
-    if (NumPoly >= MaxPoly)
+    if (!CanInsertMesh(Mesh))
     {
-        return false;
+        return;
     }
 
-    PolyList[NumPoly] = Poly;
-    ++NumPoly;
+    const i32 FirstPoly = NumPoly;
+    NumPoly += CountMeshPoly(Mesh);
+    Reserve(NumPoly);
+    bActivePolyValid = false;
 
-    return true;
+    VPolyCluster* MeshClusters = nullptr;
+    if (bClusters && Mesh.ClusterList)
+    {
+        const i32 FirstCluster = (i32)Clusters.GetLength();
+        Clusters.Resize(FirstCluster + Mesh.NumClusters);
+        MeshClusters = &Clusters[FirstCluster];
+    }
+
+    WriteMesh(Mesh, VtxList, OverrideMaterial, FirstPoly, NumPoly, MeshClusters);
+}
+
+void VRenderList::BeginParallelInsert(i32 MaxClusters, i32 MaxNewPoly)
+{
+    // Chunks can't be allocated while tasks write to them
+    Reserve(NumPoly + MaxNewPoly);
+
+    PolyCursor.store(NumPoly);
+    bActivePolyValid = false;
+    ClusterCursor.store((i32)Clusters.GetLength());
+
+    Clusters.Resize(Clusters.GetLength() + MaxClusters);
 }
 
-void VRenderList::InsertMesh(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial)
+i32 VRenderList::InsertMeshParallel(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial, b32 bClusters)
 {
-    if (~Mesh.State & EMeshState::Active  ||
-        ~Mesh.State & EMeshState::Visible ||
-        Mesh.State & EMeshState::Culled)
+    if (!CanInsertMesh(Mesh))
     {
-        return;
+        return 0;
+    }
+
+    // Whole mesh range is reserved at once, so tasks never write to the same polygons
+    const i32 NumMeshPoly = CountMeshPoly(Mesh);
+    const i32 FirstPoly = PolyCursor.fetch_add(NumMeshPoly);
+    const i32 EndPoly = VLN_MIN(FirstPoly + NumMeshPoly, GetCapacity());
+
+    if (FirstPoly >= EndPoly)
+    {
+        return 0;
+    }
+
+    VPolyCluster* MeshClusters = nullptr;
+    if (bClusters && Mesh.ClusterList)
+    {
+        const i32 FirstCluster = ClusterCursor.fetch_add(Mesh.NumClusters);
+        VLN_ASSERT(FirstCluster + Mesh.NumClusters <= (i32)Clusters.GetLength());
+
+        MeshClusters = &Clusters[FirstCluster];
     }
 
+    WriteMesh(Mesh, VtxList, OverrideMaterial, FirstPoly, EndPoly, MeshClusters);
+
+    return EndPoly - FirstPoly;
+}
+
+void VRenderList::EndParallelInsert()
+{
+    const i32 NumReservedPoly = PolyCursor.load();
+    NumPoly = VLN_MIN(NumReservedPoly, GetCapacity());
+    NumDroppedPoly += NumReservedPoly - NumPoly;
+    Clusters.Resize(VLN_MIN(ClusterCursor.load(), (i32)Clusters.GetLength()));
+
+    // Tasks reserved ranges in any order, but backface removal walks clusters in polygon order
+    std::sort(Clusters.begin(), Clusters.end(), [](const VPolyCluster& A, const VPolyCluster& B)
+    {
+        return A.FirstPoly < B.FirstPoly;
+    });
+}
+
+b32 VRenderList::CanInsertMesh(const VMesh& Mesh) const
+{
+    return Mesh.State & EMeshState::Active  &&
+           Mesh.State & EMeshState::Visible &&
+           ~Mesh.State & EMeshState::Culled;
+}
+
+i32 VRenderList::CountMeshPoly(const VMesh& Mesh) const
+{
+    i32 Count = 0;
+
     for (i32f i = 0; i < Mesh.NumPoly; ++i)
     {
-        const VPoly& Poly = Mesh.PolyList[i];
+        const u32 State = Mesh.PolyList[i].State;
 
-        if (~Poly.State & EPolyState::Active || Poly.State & EPolyState::NotRenderTest)
+        if (State & EPolyState::Active && ~State & EPolyState::NotRenderTest)
         {
-            continue;
+            ++Count;
         }
+    }
+
+    return Count;
+}
 
-        if (!InsertPoly(Poly, VtxList, Mesh.TextureCoordsList, OverrideMaterial ? OverrideMaterial : Poly.Material))
+void VRenderList::WriteMesh(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial, i32 PolyIndex, i32 EndPoly, VPolyCluster* MeshClusters)
+{
+    const auto WritePolygons = [&](i32 FirstMeshPoly, i32 NumMeshPoly)
+    {
+        for (i32f i = FirstMeshPoly; i < FirstMeshPoly + NumMeshPoly && PolyIndex < EndPoly; ++i)
         {
-            return;
+            const VPoly& Poly = Mesh.PolyList[i];
+
+            if (~Poly.State & EPolyState::Active || Poly.State & EPolyState::NotRenderTest)
+            {
+                continue;
+            }
+
+            SetPolyFace(GetPoly(PolyIndex), Poly, VtxList, Mesh.TextureCoordsList, OverrideMaterial ? OverrideMaterial : Poly.Material);
+            ++PolyIndex;
         }
+    };
+
+    if (!MeshClusters)
+    {
+        WritePolygons(0, Mesh.NumPoly);
+        return;
+    }
+
+    // Move cluster bounds and cones to world space the same way as mesh vertices
+    Mesh.UpdateWorldMatrices();
+
+    for (i32f ClusterIndex = 0; ClusterIndex < Mesh.NumClusters; ++ClusterIndex)
+    {
+        const VPolyCluster& MeshCluster = Mesh.ClusterList[ClusterIndex];
+        VPolyCluster& Cluster = MeshClusters[ClusterIndex];
+
+        Cluster.FirstPoly = PolyIndex;
+        Cluster.Radius = MeshCluster.Radius;
+        Cluster.Angle = MeshCluster.Angle;
+
+        VMatrix44::MulVecMat(MeshCluster.Center, Mesh.MatWorld, Cluster.Center);
+        VMatrix44::MulVecMat(MeshCluster.Axis, Mesh.MatWorldRotationOnly, Cluster.Axis);
+
+        WritePolygons(MeshCluster.FirstPoly, MeshCluster.NumPoly);
+        Cluster.NumPoly = PolyIndex - Cluster.FirstPoly;
     }
 }
 
@@ -72,10 +216,15 @@ void VRenderList::ResetStateAndSaveList()
     NumPoly -= NumAdditionalPoly;
     NumAdditionalPoly = 0;
 
-    // Restore polygons
+    NumGrownChunks = 0;
+    NumDroppedPoly = 0;
+
+    // Restore polygons, all active ones pass render test again
+    ActivePoly.Clear();
+
     for (i32f i = 0; i < NumPoly; ++i)
     {
-        VPolyFace& Poly = PolyList[i];
+        VPolyFace& Poly = GetPoly(i);
         if (~Poly.State & EPolyState::Active)
         {
             continue;
@@ -83,31 +232,70 @@ void VRenderList::ResetStateAndSaveList()
 
         Poly.State &= ~(EPolyState::Clipped | EPolyState::Backface | EPolyState::Lit);
         Poly.LitColor[2] = Poly.LitColor[1] = Poly.LitColor[0] = Poly.Material->Color;
+
+        ActivePoly.EmplaceBack((i32)i);
     }
+
+    bActivePolyValid = true;
+}
+
+void VRenderList::UpdateActivePoly()
+{
+    if (bActivePolyValid)
+    {
+        return;
+    }
+
+    ActivePoly.Clear();
+
+    for (i32f i = 0; i < NumPoly; ++i)
+    {
+        const VPolyFace& Poly = GetPoly(i);
+        if (Poly.State & EPolyState::Active && ~Poly.State & EPolyState::NotRenderTest)
+        {
+            ActivePoly.EmplaceBack((i32)i);
+        }
+    }
+
+    bActivePolyValid = true;
+}
+
+void VRenderList::CompactActivePoly(i32 NumKept, i32 NumScanned)
+{
+    const i32 NumAppended = (i32)ActivePoly.GetLength() - NumScanned;
+    i32* Indices = ActivePoly.GetData();
+
+    if (NumKept != NumScanned)
+    {
+        for (i32f i = 0; i < NumAppended; ++i)
+        {
+            Indices[NumKept + i] = Indices[NumScanned + i];
+        }
+    }
+
+    ActivePoly.Resize(NumKept + NumAppended);
 }
 
 void VRenderList::Transform(const VMatrix44& M, ETransformType Type)
 {
+    UpdateActivePoly();
+
     VVector4 Res;
 
     switch (Type)
     {
     case ETransformType::LocalOnly:
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (const i32 PolyIndex : ActivePoly)
         {
-            VPolyFace* Poly = &PolyList[i];
-            if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-            {
-                continue;
-            }
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
             for (i32f V = 0; V < 3; ++V)
             {
                 VMatrix44::MulVecMat(Poly->LocalVtx[V].Position, M, Res);
                 Poly->LocalVtx[V].Position = Res;
 
-                if (Poly->LocalVtx[V].Attr & EVertexAttr::HasNormal)
+                if (Poly->TransVtx[V].Attr & EVertexAttr::HasNormal)
                 {
                     VMatrix44::MulVecMat(Poly->LocalVtx[V].Normal, M, Res);
                     Poly->LocalVtx[V].Normal = Res;
@@ -118,14 +306,9 @@ void VRenderList::Transform(const VMatrix44& M, ETransformType Type)
 
     case ETransformType::TransOnly:
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (const i32 PolyIndex : ActivePoly)
         {
-            VPolyFace* Poly = &PolyList[i];
-            if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-
-            {
-                continue;
-            }
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
             for (i32f V = 0; V < 3; ++V)
             {
@@ -143,19 +326,15 @@ void VRenderList::Transform(const VMatrix44& M, ETransformType Type)
 
     case ETransformType::LocalToTrans:
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (const i32 PolyIndex : ActivePoly)
         {
-            VPolyFace* Poly = &PolyList[i];
-            if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-            {
-                continue;
-            }
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
             for (i32f V = 0; V < 3; ++V)
             {
                 VMatrix44::MulVecMat(Poly->LocalVtx[V].Position, M, Poly->TransVtx[V].Position);
 
-                if (Poly->LocalVtx[V].Attr & EVertexAttr::HasNormal)
+                if (Poly->TransVtx[V].Attr & EVertexAttr::HasNormal)
                 {
                     VMatrix44::MulVecMat(Poly->LocalVtx[V].Normal, M, Poly->TransVtx[V].Normal);
                 }
@@ -168,15 +347,13 @@ void VRenderList::Transform(const VMatrix44& M, ETransformType Type)
 // LocalToTrans or TransOnly
 void VRenderList::TransformModelToWorld(const VPoint4& WorldPos, ETransformType Type)
 {
+    UpdateActivePoly();
+
     if (Type == ETransformType::LocalToTrans)
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (const i32 PolyIndex : ActivePoly)
         {
-            VPolyFace* Poly = &PolyList[i];
-            if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-            {
-                continue;
-            }
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
             for (i32f V = 0; V < 3; ++V)
             {
@@ -186,13 +363,9 @@ void VRenderList::TransformModelToWorld(const VPoint4& WorldPos, ETransformType
     }
     else // TransOnly
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (const i32 PolyIndex : ActivePoly)
         {
-            VPolyFace* Poly = &PolyList[i];
-            if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-            {
-                continue;
-            }
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
             for (i32f V = 0; V < 3; ++V)
             {
@@ -203,19 +376,119 @@ void VRenderList::TransformModelToWorld(const VPoint4& WorldPos, ETransformType
 }
 
 i32 VRenderList::RemoveBackfaces(const VCamera& Cam)
+{
+    enum EClusterFacing
+    {
+        Front = 0,
+        Back,
+        Mixed
+    };
+
+    // Angle between polygon normal and view vector after which polygon is backface
+    const f32 MaxViewAngle = bTerrain ? std::acos(TerrainBackfaceCos) : Math.Pi * 0.5f;
+
+    // One test per cluster with cone of view vectors to bounding sphere against cone of normals
+    const auto ClassifyCluster = [&Cam, MaxViewAngle](const VPolyCluster& Cluster) -> EClusterFacing
+    {
+        const VVector4 View = Cam.Position - Cluster.Center;
+        const f32 Distance = View.GetLength();
+
+        if (Distance <= Cluster.Radius)
+        {
+            return Mixed;
+        }
+
+        const f32 ViewSpread = std::asin(Cluster.Radius / Distance);
+        const f32 ViewAngle = std::acos(VLN_MAX(-1.0f, VLN_MIN(1.0f, VVector4::Dot(View, Cluster.Axis) / Distance)));
+
+        if (ViewAngle - Cluster.Angle - ViewSpread > MaxViewAngle)
+        {
+            return Back;
+        }
+        if (ViewAngle + Cluster.Angle + ViewSpread < MaxViewAngle)
+        {
+            return Front;
+        }
+
+        return Mixed;
+    };
+
+    UpdateActivePoly();
+
+    // Clusters and active indices are both in polygon order, so cluster ranges are found by indices only
+    const i32* Indices = ActivePoly.GetData();
+    const i32 NumActive = (i32)ActivePoly.GetLength();
+
+    i32 NumBackfaced = 0;
+    i32 NumKept = 0;
+    i32 Cursor = 0;
+
+    for (const auto& Cluster : Clusters)
+    {
+        const i32 ClusterBegin = (i32)(std::lower_bound(Indices + Cursor, Indices + NumActive, Cluster.FirstPoly) - Indices);
+        const i32 ClusterEnd = (i32)(std::lower_bound(Indices + ClusterBegin, Indices + NumActive, Cluster.FirstPoly + Cluster.NumPoly) - Indices);
+
+        NumBackfaced += RemoveBackfacesInRange(Cam, Cursor, ClusterBegin, NumKept);
+        Cursor = ClusterEnd;
+
+        if (ClusterBegin == ClusterEnd)
+        {
+            continue;
+        }
+
+        const EClusterFacing Facing = ClassifyCluster(Cluster);
+
+        if (Facing == Mixed)
+        {
+            NumBackfaced += RemoveBackfacesInRange(Cam, ClusterBegin, ClusterEnd, NumKept);
+        }
+        else if (Facing == Back)
+        {
+            for (i32f i = ClusterBegin; i < ClusterEnd; ++i)
+            {
+                const i32 PolyIndex = Indices[i];
+                VPolyFace* Poly = &GetPoly(PolyIndex);
+
+                if (Poly->Material->Attr & EMaterialAttr::TwoSided)
+                {
+                    ActivePoly[NumKept++] = PolyIndex;
+                    continue;
+                }
+
+                Poly->State |= EPolyState::Backface;
+                ++NumBackfaced;
+            }
+        }
+        else
+        {
+            // Front facing polygons aren't touched at all
+            for (i32f i = ClusterBegin; i < ClusterEnd; ++i)
+            {
+                ActivePoly[NumKept++] = Indices[i];
+            }
+        }
+    }
+
+    NumBackfaced += RemoveBackfacesInRange(Cam, Cursor, NumActive, NumKept);
+    CompactActivePoly(NumKept, NumActive);
+
+    return NumBackfaced;
+}
+
+i32 VRenderList::RemoveBackfacesInRange(const VCamera& Cam, i32 Begin, i32 End, i32& NumKept)
 {
     i32 NumBackfaced = 0;
 
     if (bTerrain)
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (i32f i = Begin; i < End; ++i)
         {
-            VPolyFace* Poly = &PolyList[i];
+            const i32 PolyIndex = ActivePoly[i];
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
-            if (~Poly->State & EPolyState::Active ||
-                Poly->State & EPolyState::NotRenderTest ||
-                Poly->Material->Attr & EMaterialAttr::TwoSided)
+            if (Poly->Material->Attr & EMaterialAttr::TwoSided)
             {
+                ActivePoly[NumKept++] = PolyIndex;
                 continue;
             }
 
@@ -229,23 +502,27 @@ i32 VRenderList::RemoveBackfaces(const VCamera& Cam)
             const VVector4 View = Cam.Position - Poly->LocalVtx[0].Position;
 
             // If > 0 then N watch in the same direction as View vector and visible
-            if (VVector4::Dot(View, N) / (N.GetLength() * View.GetLength()) < -0.45f)
+            if (VVector4::Dot(View, N) / (N.GetLength() * View.GetLength()) < TerrainBackfaceCos)
             {
                 Poly->State |= EPolyState::Backface;
                 ++NumBackfaced;
             }
+            else
+            {
+                ActivePoly[NumKept++] = PolyIndex;
+            }
         }
     }
     else
     {
-        for (i32f i = 0; i < NumPoly; ++i)
+        for (i32f i = Begin; i < End; ++i)
         {
-            VPolyFace* Poly = &PolyList[i];
+            const i32 PolyIndex = ActivePoly[i];
+            VPolyFace* Poly = &GetPoly(PolyIndex);
 
-            if (~Poly->State & EPolyState::Active  ||
-                Poly->State & EPolyState::NotRenderTest ||
-                Poly->Material->Attr & EMaterialAttr::TwoSided)
+            if (Poly->Material->Attr & EMaterialAttr::TwoSided)
             {
+                ActivePoly[NumKept++] = PolyIndex;
                 continue;
             }
 
@@ -263,6 +540,10 @@ i32 VRenderList::RemoveBackfaces(const VCamera& Cam)
                 Poly->State |= EPolyState::Backface;
                 ++NumBackfaced;
             }
+            else
+            {
+                ActivePoly[NumKept++] = PolyIndex;
+            }
         }
     }
 
@@ -271,12 +552,13 @@ i32 VRenderList::RemoveBackfaces(const VCamera& Cam)
 
 void VRenderList::Light(const VCamera& Cam, const TArray<VLight>& Lights)
 {
-    for (i32f PolyIndex = 0; PolyIndex < NumPoly; ++PolyIndex)
+    UpdateActivePoly();
+
+    for (const i32 PolyIndex : ActivePoly)
     {
-        // Check if we need to draw this poly
-        VPolyFace* Poly = &PolyList[PolyIndex];
+        VPolyFace* Poly = &GetPoly(PolyIndex);
 
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotLightTest)
+        if (Poly->State & EPolyState::Lit)
         {
             continue;
         }
@@ -726,15 +1008,67 @@ void VRenderList::Light(const VCamera& Cam, const TArray<VLight>& Lights)
     }
 }
 
-void VRenderList::TransformWorldToCamera(const VCamera& Camera)
+void VRenderList::Shadow(const VShadowMap& ShadowMap, f32 Intensity)
 {
-    for (i32f i = 0; i < NumPoly; ++i)
+    // 8 bit fraction of color which stays, applied to red and blue at once
+    const auto Darken = [Intensity](VColorARGB Color, f32 Shadow) -> VColorARGB
+    {
+        const u32 Keep = (u32)((1.0f - Intensity * Shadow) * 256.0f + 0.5f);
+        const u32 RB = (((Color.ARGB & 0x00FF00FF) * Keep) >> 8) & 0x00FF00FF;
+        const u32 G = (((Color.ARGB & 0x0000FF00) * Keep) >> 8) & 0x0000FF00;
+
+        return (Color.ARGB & 0xFF000000) | RB | G;
+    };
+
+    UpdateActivePoly();
+
+    JobSystem.ParallelFor((i32)ActivePoly.GetLength(), 256, [&](i32 Begin, i32 End)
     {
-        VPolyFace* Poly = &PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
+        for (i32f i = Begin; i < End; ++i)
         {
-            continue;
+            VPolyFace* Poly = &GetPoly(ActivePoly[i]);
+
+            if (~Poly->State & EPolyState::Lit)
+            {
+                continue;
+            }
+
+            if (Poly->Material->Attr & EMaterialAttr::ShadeModeFlat)
+            {
+                const f32 Shadow = (
+                    ShadowMap.GetShadow(Poly->TransVtx[0].Position) +
+                    ShadowMap.GetShadow(Poly->TransVtx[1].Position) +
+                    ShadowMap.GetShadow(Poly->TransVtx[2].Position)
+                ) * (1.0f / 3.0f);
+
+                if (Shadow > 0.0f)
+                {
+                    Poly->LitColor[0] = Darken(Poly->LitColor[0], Shadow);
+                }
+            }
+            else if (Poly->Material->Attr & EMaterialAttr::ShadeModeGouraud)
+            {
+                for (i32f V = 0; V < 3; ++V)
+                {
+                    const f32 Shadow = ShadowMap.GetShadow(Poly->TransVtx[V].Position);
+
+                    if (Shadow > 0.0f)
+                    {
+                        Poly->LitColor[V] = Darken(Poly->LitColor[V], Shadow);
+                    }
+                }
+            }
         }
+    });
+}
+
+void VRenderList::TransformWorldToCamera(const VCamera& Camera)
+{
+    UpdateActivePoly();
+
+    for (const i32 PolyIndex : ActivePoly)
+    {
+        VPolyFace* Poly = &GetPoly(PolyIndex);
 
         for (i32f V = 0; V < 3; ++V)
         {
@@ -763,17 +1097,20 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
         ZIn      = VLN_BIT(7),
     };
 
-    const i32f SavedNumPoly = NumPoly;
+    UpdateActivePoly();
+
+    // Polygons made by clipping are appended to active indices, compaction moves them after kept ones
+    const i32 NumScanned = (i32)ActivePoly.GetLength();
+    i32 NumKept = 0;
     i32 NumClipped = 0;
 
-    for (i32f PolyIndex = 0; PolyIndex < SavedNumPoly; ++PolyIndex)
+    for (i32f i = 0; i < NumScanned; ++i)
     {
-        VPolyFace& Poly = PolyList[PolyIndex];
+        // Index is kept unless polygon gets clipped below
+        const i32 PolyIndex = ActivePoly[i];
+        ActivePoly[NumKept++] = PolyIndex;
 
-        if (~Poly.State & EPolyState::Active  || Poly.State & EPolyState::NotRenderTest)
-        {
-            continue;
-        }
+        VPolyFace& Poly = GetPoly(PolyIndex);
 
         u32 ClipCodes[3] = { 0, 0, 0 };
         f32 ZFactor;
@@ -824,6 +1161,7 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
                  ClipCodes[2] & EClipCode::XGreater))
             {
                 Poly.State |= EPolyState::Clipped;
+                --NumKept;
                 ++NumClipped;
                 continue;
             }
@@ -874,6 +1212,7 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
                  ClipCodes[2] & EClipCode::YGreater))
             {
                 Poly.State |= EPolyState::Clipped;
+                --NumKept;
                 ++NumClipped;
                 continue;
             }
@@ -934,6 +1273,7 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
                  ClipCodes[2] & EClipCode::ZGreater))
             {
                 Poly.State |= EPolyState::Clipped;
+                --NumKept;
                 ++NumClipped;
                 continue;
             }
@@ -975,6 +1315,7 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
                     // Copy current poly and mark it "clipped"
                     VPolyFace NewPoly = Poly;
                     Poly.State |= EPolyState::Clipped;
+                    --NumKept;
 
                     // Recompute X and Y for ZNearClip
                     VVector4 Direction = NewPoly.TransVtx[V1].Position - NewPoly.TransVtx[V0].Position;
@@ -1023,6 +1364,7 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
                     VPolyFace NewPoly1, NewPoly2;
                     NewPoly2 = NewPoly1 = Poly;
                     Poly.State |= EPolyState::Clipped;
+                    --NumKept;
 
                     // Get vertex indices
                     if (ClipCodes[0] & EClipCode::ZLess)
@@ -1116,19 +1458,195 @@ i32 VRenderList::Clip(const VCamera& Camera, EClipFlags::Type Flags)
         }
     }
 
+    CompactActivePoly(NumKept, NumScanned);
+
+    if (Flags & (EClipFlags::X | EClipFlags::Y))
+    {
+        NumClipped += ClipToGuardBand(Camera, Flags);
+    }
+
     return NumClipped;
 }
 
-void VRenderList::TransformCameraToPerspective(const VCamera& Cam)
+i32 VRenderList::ClipToGuardBand(const VCamera& Camera, EClipFlags::Type Flags)
 {
-    for (i32f i = 0; i < NumPoly; ++i)
+    enum EGuardPlane
+    {
+        XGreater = VLN_BIT(1),
+        XLess    = VLN_BIT(2),
+
+        YGreater = VLN_BIT(3),
+        YLess    = VLN_BIT(4),
+    };
+
+    /*
+        In camera space W = Z, so guard band planes are X = +-GX * Z and Y = +-GY * Z.
+        Signed distance to plane is linear along edge, so clipped vertex
+        is lerp of all vertex components with t = D0 / (D0 - D1)
+    */
+    const f32 GX = (Flags & EClipFlags::X) ? GuardBandScale * (0.5f * Camera.ViewplaneSize.X) / Camera.ViewDist : 0.0f;
+    const f32 GY = (Flags & EClipFlags::Y) ? GuardBandScale * (0.5f * Camera.ViewplaneSize.Y) / Camera.ViewDist : 0.0f;
+
+    const i32 NumScanned = (i32)ActivePoly.GetLength();
+    i32 NumKept = 0;
+    i32 NumClipped = 0;
+
+    // Also goes through polygons added by near Z clipping
+    for (i32f i = 0; i < NumScanned; ++i)
     {
-        VPolyFace* Poly = &PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
+        const i32 PolyIndex = ActivePoly[i];
+        ActivePoly[NumKept++] = PolyIndex;
+
+        VPolyFace& Poly = GetPoly(PolyIndex);
+
+        // Get violated planes
+        u32 Planes = 0;
+
+        for (i32f V = 0; V < 3; ++V)
+        {
+            const VVertex& Vtx = Poly.TransVtx[V];
+
+            if (Flags & EClipFlags::X)
+            {
+                const f32 ZTest = GX * Vtx.Z;
+
+                if (Vtx.X > ZTest)
+                {
+                    Planes |= EGuardPlane::XGreater;
+                }
+                else if (Vtx.X < -ZTest)
+                {
+                    Planes |= EGuardPlane::XLess;
+                }
+            }
+
+            if (Flags & EClipFlags::Y)
+            {
+                const f32 ZTest = GY * Vtx.Z;
+
+                if (Vtx.Y > ZTest)
+                {
+                    Planes |= EGuardPlane::YGreater;
+                }
+                else if (Vtx.Y < -ZTest)
+                {
+                    Planes |= EGuardPlane::YLess;
+                }
+            }
+        }
+
+        if (!Planes)
         {
             continue;
         }
 
+        // Sutherland-Hodgman against each violated plane
+        VVertex Buffers[2][MaxGuardBandVtx];
+        VVertex* InVtx = Buffers[0];
+        VVertex* OutVtx = Buffers[1];
+
+        i32f NumVtx = 3;
+        InVtx[0] = Poly.TransVtx[0];
+        InVtx[1] = Poly.TransVtx[1];
+        InVtx[2] = Poly.TransVtx[2];
+
+        for (u32 Plane = EGuardPlane::XGreater; Plane <= EGuardPlane::YLess && NumVtx >= 3; Plane <<= 1)
+        {
+            if (~Planes & Plane)
+            {
+                continue;
+            }
+
+            f32 Dist[MaxGuardBandVtx];
+
+            for (i32f V = 0; V < NumVtx; ++V)
+            {
+                const VVertex& Vtx = InVtx[V];
+
+                switch (Plane)
+                {
+                    case EGuardPlane::XGreater: Dist[V] = GX * Vtx.Z - Vtx.X; break;
+                    case EGuardPlane::XLess:    Dist[V] = GX * Vtx.Z + Vtx.X; break;
+                    case EGuardPlane::YGreater: Dist[V] = GY * Vtx.Z - Vtx.Y; break;
+                    default:                    Dist[V] = GY * Vtx.Z + Vtx.Y; break;
+                }
+            }
+
+            i32f NumOutVtx = 0;
+
+            for (i32f V = 0; V < NumVtx; ++V)
+            {
+                const i32f NextV = (V + 1 < NumVtx) ? V + 1 : 0;
+
+                if (Dist[V] >= 0.0f)
+                {
+                    OutVtx[NumOutVtx++] = InVtx[V];
+                }
+
+                if ((Dist[V] >= 0.0f) != (Dist[NextV] >= 0.0f))
+                {
+                    const f32 T = Dist[V] / (Dist[V] - Dist[NextV]);
+                    VVertex& NewVtx = OutVtx[NumOutVtx++];
+
+                    NewVtx.Attr = InVtx[V].Attr;
+                    for (i32f C = 0; C < 10; ++C)
+                    {
+                        NewVtx.C[C] = InVtx[V].C[C] + (InVtx[NextV].C[C] - InVtx[V].C[C]) * T;
+                    }
+
+                    if (NewVtx.Attr & EVertexAttr::HasNormal)
+                    {
+                        NewVtx.Normal.NormalizeFast();
+                    }
+                }
+            }
+
+            VVertex* TempVtx;
+            VLN_SWAP(InVtx, OutVtx, TempVtx);
+            NumVtx = NumOutVtx;
+        }
+
+        // Copy current poly and mark it "clipped"
+        VPolyFace NewPoly = Poly;
+        Poly.State |= EPolyState::Clipped;
+        --NumKept;
+        ++NumClipped;
+
+        // Fan triangulation, vertex 0 is shared
+        NewPoly.TransVtx[0] = InVtx[0];
+
+        for (i32f V = 1; V < NumVtx - 1; ++V)
+        {
+            NewPoly.TransVtx[1] = InVtx[V];
+            NewPoly.TransVtx[2] = InVtx[V + 1];
+
+            // Recompute poly normal length
+            const VVector4 Vec1 = NewPoly.TransVtx[1].Position - NewPoly.TransVtx[0].Position;
+            const VVector4 Vec2 = NewPoly.TransVtx[2].Position - NewPoly.TransVtx[0].Position;
+            VVector4 VecNormal;
+
+            VVector4::Cross(Vec1, Vec2, VecNormal);
+            NewPoly.NormalLength = VecNormal.GetLengthFast();
+
+            // Insert
+            InsertPolyFace(NewPoly);
+            ++NumAdditionalPoly;
+        }
+    }
+
+    CompactActivePoly(NumKept, NumScanned);
+
+    return NumClipped;
+}
+
+void VRenderList::TransformCameraToPerspective(const VCamera& Cam)
+{
+    UpdateActivePoly();
+
+    for (const i32 PolyIndex : ActivePoly)
+    {
+        VPolyFace* Poly = &GetPoly(PolyIndex);
+
         for (i32f V = 0; V < 3; ++V)
         {
             Poly->TransVtx[V].X = Cam.ViewDist * Poly->TransVtx[V].X / Poly->TransVtx[V].Z;
@@ -1139,13 +1657,11 @@ void VRenderList::TransformCameraToPerspective(const VCamera& Cam)
 
 void VRenderList::ConvertFromHomogeneous()
 {
-    for (i32f i = 0; i < NumPoly; ++i)
+    UpdateActivePoly();
+
+    for (const i32 PolyIndex : ActivePoly)
     {
-        VPolyFace* Poly = &PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-        {
-            continue;
-        }
+        VPolyFace* Poly = &GetPoly(PolyIndex);
 
         for (i32f V = 0; V < 3; ++V)
         {
@@ -1156,16 +1672,14 @@ void VRenderList::ConvertFromHomogeneous()
 
 void VRenderList::TransformPerspectiveToScreen(const VCamera& Cam)
 {
+    UpdateActivePoly();
+
     const f32 Alpha = (f32)Renderer.GetScreenWidth() * 0.5f - 0.5f;
     const f32 Beta = (f32)Renderer.GetScreenHeight() * 0.5f - 0.5f;
 
-    for (i32f i = 0; i < NumPoly; ++i)
+    for (const i32 PolyIndex : ActivePoly)
     {
-        VPolyFace* Poly = &PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-        {
-            continue;
-        }
+        VPolyFace* Poly = &GetPoly(PolyIndex);
 
         for (i32f V = 0; V < 3; ++V)
         {
@@ -1177,16 +1691,14 @@ void VRenderList::TransformPerspectiveToScreen(const VCamera& Cam)
 
 void VRenderList::TransformCameraToScreen(const VCamera& Cam)
 {
+    UpdateActivePoly();
+
     const f32 Alpha = (f32)Renderer.GetScreenWidth() * 0.5f - 0.5f;
     const f32 Beta = (f32)Renderer.GetScreenHeight() * 0.5f - 0.5f;
 
-    for (i32f i = 0; i < NumPoly; ++i)
+    for (const i32 PolyIndex : ActivePoly)
     {
-        VPolyFace* Poly = &PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
-        {
-            continue;
-        }
+        VPolyFace* Poly = &GetPoly(PolyIndex);
 
         for (i32f V = 0; V < 3; ++V)
         {
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <cstdlib>
+#include <atomic>
+#include "Common/Types/Array.h"
 #include "Common/Math/Minimal.h"
 #include "Engine/Graphics/Types/Polygon.h"
 #include "Engine/Graphics/Scene/Camera.h"
 #include "Engine/Graphics/Types/TransformType.h"
 #include "Engine/Graphics/Scene/Mesh.h"
 #include "Engine/Graphics/Scene/Light.h"
+#include "Engine/Graphics/Rendering/ShadowMap.h"
 
 namespace Volition
 {
@@ -28,30 +31,93 @@ VLN_DEFINE_LOG_CHANNEL(hLogRenderList, "RenderList");
 VLN_DECL_ALIGN_SSE() class VRenderList
 {
 public:
-    i32 MaxPoly = 0;
+    /** Guard band in half viewplane sizes, polygons inside it are only scissored by rasterizer */
+    static constexpr f32 GuardBandScale = 4.0f;
 
+    /** Max vertices after clipping triangle by 4 guard band planes */
+    static constexpr i32f MaxGuardBandVtx = 7;
+
+    /** Terrain polygons are backfaces only when turned away further than this cosine */
+    static constexpr f32 TerrainBackfaceCos = -0.45f;
+
+    /** Polygons live in chunks which are allocated on demand and kept between frames */
+    static constexpr i32f PolyChunkShift = 12;
+    static constexpr i32f PolyChunkSize = 1 << PolyChunkShift;
+    static constexpr i32f PolyChunkMask = PolyChunkSize - 1;
+
+public:
     i32 NumPoly = 0;
     i32 NumAdditionalPoly = 0;
 
+    /** Since last reset, for profiling. Polygons are dropped only if parallel insertion reserved too few */
+    i32 NumGrownChunks = 0;
+    i32 NumDroppedPoly = 0;
+
     b8 bTerrain = false;
 
-    VPolyFace* PolyList = nullptr;
+    /** World space clusters of inserted meshes, polygons between clusters are tested one by one */
+    TArray<VPolyCluster> Clusters;
+
+    /** Next free polygon and cluster during parallel insertion */
+    std::atomic<i32> PolyCursor;
+    std::atomic<i32> ClusterCursor;
+
+private:
+    TArray<VPolyFace*> PolyChunks;
+
+    /**
+        Ascending indices of active polygons which passed render test so far.
+        Culling stages compact it, clipping appends new polygons, other stages only go through it
+    */
+    TArray<i32> ActivePoly;
+    b32 bActivePolyValid = true; /** False after meshes were inserted, rebuilt by next stage */
 
 public:
-    VRenderList(i32 InMaxPoly)
+    VRenderList() = default;
+    ~VRenderList();
+
+    VLN_FINLINE VPolyFace& GetPoly(i32 Index)
+    {
+        return PolyChunks[Index >> PolyChunkShift][Index & PolyChunkMask];
+    }
+
+    VLN_FINLINE const VPolyFace& GetPoly(i32 Index) const
+    {
+        return PolyChunks[Index >> PolyChunkShift][Index & PolyChunkMask];
+    }
+
+    /** Valid after any processing stage */
+    VLN_FINLINE const TArray<i32>& GetActivePoly() const
+    {
+        VLN_ASSERT(bActivePolyValid);
+        return ActivePoly;
+    }
+
+    VLN_FINLINE i32 GetCapacity() const
     {
-        MaxPoly = InMaxPoly;
-        PolyList = new VPolyFace[InMaxPoly];
+        return (i32)PolyChunks.GetLength() * PolyChunkSize;
     }
 
-    ~VRenderList()
+    VLN_FINLINE i32 GetMemorySize() const
     {
-        delete[] PolyList;
+        return GetCapacity() * (i32)sizeof(VPolyFace);
     }
 
+    /** Allocates chunks until InNumPoly polygons fit */
+    void Reserve(i32 InNumPoly);
+
     b32 InsertPoly(const VPoly& Poly, const VVertex* VtxList, const VPoint2* TextureCoordsList, const VMaterial* Material);
     b32 InsertPolyFace(const VPolyFace& Poly);
-    void InsertMesh(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial = nullptr);
+    void InsertMesh(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial = nullptr, b32 bClusters = true);
+
+    /**
+        Meshes can be inserted from many threads between Begin and End, each call reserves its range atomically.
+        MaxClusters and MaxNewPoly are totals of meshes which may be inserted
+    */
+    void BeginParallelInsert(i32 MaxClusters, i32 MaxNewPoly);
+    /** Returns num inserted polygons */
+    i32 InsertMeshParallel(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial = nullptr, b32 bClusters = true);
+    void EndParallelInsert();
 
     void Transform(const VMatrix44& M, ETransformType Type);
 
@@ -67,6 +133,9 @@ public:
 
     void Light(const VCamera& Cam, const TArray<VLight>& Lights);
 
+    /** Darkens lit colors by shadow map per vertex, flat polygons take average of vertices. Camera space, after Light() */
+    void Shadow(const VShadowMap& ShadowMap, f32 Intensity);
+
     /* Returns num clipped polygons **/
     i32 Clip(const VCamera& Camera, EClipFlags::Type Flags = EClipFlags::Full);
 
@@ -76,10 +145,51 @@ public:
     {
         NumPoly = 0;
         NumAdditionalPoly = 0;
+        NumGrownChunks = 0;
+        NumDroppedPoly = 0;
+        Clusters.Clear();
+
+        ActivePoly.Clear();
+        bActivePolyValid = true;
     }
 
     void ResetStateAndSaveList();
 
+private:
+    void SetPolyFace(VPolyFace& PolyFace, const VPoly& Poly, const VVertex* VtxList, const VPoint2* TextureCoordsList, const VMaterial* Material);
+
+    b32 CanInsertMesh(const VMesh& Mesh) const;
+    i32 CountMeshPoly(const VMesh& Mesh) const;
+
+    /* Writes mesh polygons to [PolyIndex, EndPoly) and fills Mesh.NumClusters clusters if given **/
+    void WriteMesh(VMesh& Mesh, const VVertex* VtxList, const VMaterial* OverrideMaterial, i32 PolyIndex, i32 EndPoly, VPolyCluster* MeshClusters);
+
+    /** Scans all polygons if active indices aren't valid */
+    void UpdateActivePoly();
+
+    /** Moves indices appended after first NumScanned ones to NumKept */
+    void CompactActivePoly(i32 NumKept, i32 NumScanned);
+
+    VLN_FINLINE void AppendActivePoly(i32 PolyIndex)
+    {
+        if (!bActivePolyValid)
+        {
+            return;
+        }
+
+        const VPolyFace& Poly = GetPoly(PolyIndex);
+        if (Poly.State & EPolyState::Active && ~Poly.State & EPolyState::NotRenderTest)
+        {
+            ActivePoly.EmplaceBack(PolyIndex);
+        }
+    }
+
+    /* Per polygon test of active indices [Begin, End), kept ones are written from NumKept. Returns num backfaced polygons **/
+    i32 RemoveBackfacesInRange(const VCamera& Cam, i32 Begin, i32 End, i32& NumKept);
+
+    /* Splits polygons crossing guard band, returns num clipped polygons **/
+    i32 ClipToGuardBand(const VCamera& Camera, EClipFlags::Type Flags);
+
 public:
     VLN_DEFINE_ALIGN_OPERATORS_SSE()
 };
@@ -1,8 +1,11 @@
 #include <cstdarg>
+#include <bit>
+#include <emmintrin.h>
 #include "SDL_image.h"
 #include "Common/Platform/Memory.h"
 #include "Engine/Core/Window.h"
 #include "Engine/Core/Time.h"
+#include "Engine/Core/FrameArena.h"
 #include "Engine/Graphics/Rendering/Renderer.h"
 #include "Engine/World/World.h"
 
@@ -28,6 +31,9 @@ void VRenderer::StartUp()
         VideoSurface.Create(SDLSurface);
         VideoSurface.bDestroyable = false;
 
+        BackSurfaceIndex = 0;
+        BackSurface = &BackSurfaces[BackSurfaceIndex];
+
         UpdateRenderTargetSize();
     }
 
@@ -47,27 +53,53 @@ void VRenderer::StartUp()
 
     // Init renderer stuff 
     {
-        BaseRenderList = new VRenderList(MaxBaseRenderListPoly);
+        BaseRenderList = new VRenderList();
 
-        TerrainRenderList = new VRenderList(MaxTerrainRenderListPoly);
+        TerrainRenderList = new VRenderList();
         TerrainRenderList->bTerrain = true;
     }
 
     // Set up shadow material
     {
         ShadowMaterial.Init();
-        ShadowMaterial.Attr = EMaterialAttr::ShadeModeEmissive;
+        ShadowMaterial.Attr = EMaterialAttr::ShadeModeEmissive | EMaterialAttr::Shadow;
         ShadowMaterial.Color = VColorARGB::Black;
     }
 
+    // Set up post process chain
+    {
+        PostProcessChain.AddPass(&ColorCorrectionPass);
+    }
+
+    // Start present thread
+    {
+        PresentSurface = nullptr;
+        bPresentPending = false;
+        bPresentFlipPending = false;
+        bPresentShutDown = false;
+
+        bPresentThread = Config.RenderSpec.bPresentThread;
+        if (bPresentThread)
+        {
+            StartPresentThread();
+        }
+    }
+
     // Log
     VLN_NOTE(hLogRenderer, "Initialized with %s pixel format\n", SDL_GetPixelFormatName(Config.RenderSpec.SDLPixelFormatEnum));
 }
 
 void VRenderer::ShutDown()
 {
+    // Stop present thread before anything it uses goes away
+    if (bPresentThread)
+    {
+        StopPresentThread();
+    }
+
     // Shut down TTF
     {
+        GlyphAtlas.Destroy();
         TTF_CloseFont(Font);
         TTF_Quit();
     }
@@ -80,13 +112,18 @@ void VRenderer::ShutDown()
     // Free renderer stuff
     {
         ShadowMaterial.Destroy();
+        PostProcessChain.Clear();
 
         ZBuffer.Destroy();
+        ShadowMask.Destroy();
         delete TerrainRenderList;
         delete BaseRenderList;
 
         // Don't destroy VideoSurface
-        BackSurface.Destroy();
+        for (i32f i = 0; i < NumBackSurfaces; ++i)
+        {
+            BackSurfaces[i].Destroy();
+        }
     }
 }
 
@@ -103,8 +140,6 @@ void VRenderer::RenderFrameAndFlip()
 {
     Renderer.PreRender();
     Renderer.Render();
-    Renderer.PostProcess();
-    Renderer.RenderUI();
     Renderer.PostRender();
 }
 
@@ -114,23 +149,37 @@ void VRenderer::SetTerrain(VMesh& TerrainMesh)
     TerrainMesh.ResetRenderState();
     TerrainMesh.TransformModelToWorld();
     TerrainRenderList->InsertMesh(TerrainMesh, TerrainMesh.TransVtxList);
+
+    // Terrain is square grid
+    const i32 VerticesInRow = (i32)(Math.Sqrt((f32)TerrainMesh.NumVtx) + 0.5f);
+    OcclusionBuffer.SetTerrainOccluder(TerrainMesh.TransVtxList, VerticesInRow);
 }
 
 void VRenderer::PreRender()
 {
+    // Show previous frame as soon as present thread is done with it
+    FlipPresentedFrame();
+
+    // Texts queued before this call stay in previous arena frame, present thread is done with it only after next SubmitFrame()
+    FrameArena.NextFrame();
+
     if (RenderScale != Config.RenderSpec.RenderScale)
     {
+        WaitForPresent();
         UpdateRenderTargetSize();
-        UpdateFont();
     }
 
-    BackSurface.FillRect(nullptr, MAP_XRGB32(0x00, 0x00, 0x00));
-    ZBuffer.Clear();
+    UpdateDynamicResolution();
+
+    // Color is cleared in Render() only if environment doesn't cover target
+    ZBuffer.NextFrame();
 
     BaseRenderList->ResetList();
     TerrainRenderList->ResetStateAndSaveList();
 
     ProfileInfo.Reset();
+
+    ++FrameIndex;
 }
 
 void VRenderer::Render()
@@ -154,6 +203,7 @@ void VRenderer::Render()
     {
         // Blit first part
         VRelativeRectInt Src, Dest;
+        VRelativeRectInt Viewport = { 0, 0, ViewportSize.X, ViewportSize.Y };
 
         const f32 YCameraAngle = Math.Mod(Camera.Direction.Y + World.Environment2DMovementEffectAngle, 360.0f);
         const i32 WidthPart = Environment2D.Width / 4;
@@ -166,7 +216,7 @@ void VRenderer::Render()
         Src.W = WidthPart;
         Src.H = HeightPart;
 
-        Environment2D.Blit(&Src, &BackSurface, nullptr);
+        Environment2D.Blit(&Src, BackSurface, &Viewport);
 
         // If we have empty space on screen on right - blit this area
         i32f Remainder = Environment2D.Width - Src.X;
@@ -179,9 +229,14 @@ void VRenderer::Render()
             Dest.W = GetScreenWidth();
             Dest.H = GetScreenHeight();
 
-            Environment2D.Blit(&Src, &BackSurface, &Dest);
+            Environment2D.Blit(&Src, BackSurface, &Dest);
         }
     }
+    else
+    {
+        VRelativeRectInt Viewport = { 0, 0, ViewportSize.X, ViewportSize.Y };
+        BackSurface->FillRect(&Viewport, MAP_XRGB32(0x00, 0x00, 0x00));
+    }
 
     // Get shadow making light
     const VLight* ShadowMakingLight = World.ShadowMakingLight;
@@ -189,21 +244,93 @@ void VRenderer::Render()
     // Get buffer
     u32* Buffer;
     i32 Pitch;
-    BackSurface.Lock(Buffer, Pitch);
+    BackSurface->Lock(Buffer, Pitch);
+
+    // Cull entities with their shadows before any vertex work
+    const b32 bOcclusionCulling = Config.RenderSpec.bOcclusionCulling && OcclusionBuffer.HasOccluders();
+    if (bOcclusionCulling)
+    {
+        OcclusionBuffer.Render(Camera);
+    }
 
-    // Proccess and insert meshes
-    for (const auto Entity : World.Entities)
+    World.EntityBVH.Update(World.Entities, ShadowMakingLight, World.YShadowPosition);
+    const TArray<VEntity*>& VisibleEntities = World.EntityBVH.Cull(Camera, bOcclusionCulling ? &OcclusionBuffer : nullptr);
+
+    // Culled meshes only advance their animation
+    for (const auto Entity : World.EntityBVH.GetCulledEntities())
     {
-        if (Entity && Entity->Mesh)
+        VMesh* Mesh = Entity->Mesh;
+
+        if (Mesh->Attr & EMeshAttr::MultiFrame)
         {
-            VMesh* Mesh = Entity->Mesh;
+            Mesh->UpdateAnimation(Time.GetDeltaTime());
+        }
+
+        ++ProfileInfo.NumCulledEntities;
+        ++ProfileInfo.NumEntities;
+    }
+
+    // Proccess and insert meshes, every entity is independent task
+    PoseCache.Reset();
+
+    const f32 DeltaTime = Time.GetDeltaTime();
+    const b32 bShadows = ShadowMakingLight && ShadowMakingLight->bActive;
+    const b32 bShadowMap = bShadows && Config.RenderSpec.bShadowMap;
+
+    // Upper bound of inserted polygons, so render list grows before tasks start
+    i32 MaxClusters = 0;
+    i32 MaxNewPoly = 0;
+    for (const auto Entity : VisibleEntities)
+    {
+        const VMesh* Mesh = Entity->Mesh;
+
+        MaxClusters += Mesh->NumClusters;
+        MaxNewPoly += Mesh->NumPoly;
+
+        if (bShadows && !bShadowMap && Mesh->Attr & EMeshAttr::CastShadow)
+        {
+            MaxNewPoly += Mesh->ShadowMesh ? Mesh->ShadowMesh->NumPoly : Mesh->NumPoly;
+        }
+    }
+
+    BaseRenderList->BeginParallelInsert(MaxClusters, MaxNewPoly);
+
+    std::atomic<i32> NumCulledEntities = 0;
+    std::atomic<i32> NumReducedAnimations = 0;
+    std::atomic<i32> NumShadows = 0;
+    std::atomic<i32> NumCulledShadows = 0;
+    std::atomic<i32> NumShadowPoly = 0;
+
+    JobSystem.ParallelFor((i32)VisibleEntities.GetLength(), 1, [&](i32 Begin, i32 End)
+    {
+        TArray<VVertex>& ShadowVtxList = ShadowVtxLists[VJobSystem::GetThreadIndex()];
+
+        for (i32f EntityIndex = Begin; EntityIndex < End; ++EntityIndex)
+        {
+            VMesh* Mesh = VisibleEntities[EntityIndex]->Mesh;
+
+            // Frame before animation update, shadow mesh follows it
+            const f32 ShownFrame = Mesh->CurrentFrame;
 
             // Insert mesh
             {
                 Mesh->ResetRenderState();
                 if (Mesh->Attr & EMeshAttr::MultiFrame)
                 {
-                    Mesh->UpdateAnimationAndTransformModelToWorld(Time.GetDeltaTime());
+                    const i32 UpdateInterval = GetAnimationUpdateInterval(*Mesh, Camera);
+
+                    if (UpdateInterval > 1)
+                    {
+                        // Meshes update on different frames, so load is spread evenly
+                        const u32 Phase = (u32)(((u64)(uintptr_t)Mesh * 11400714819323198485ull) >> 32);
+                        Mesh->UpdateReducedAnimationAndTransformModelToWorld(DeltaTime, (FrameIndex + Phase) % UpdateInterval == 0);
+
+                        ++NumReducedAnimations;
+                    }
+                    else
+                    {
+                        Mesh->UpdateAnimationAndTransformModelToWorld(DeltaTime, &PoseCache);
+                    }
                 }
                 else
                 {
@@ -212,25 +339,54 @@ void VRenderer::Render()
 
                 if (Mesh->Cull(Camera))
                 {
-                    ++ProfileInfo.NumCulledEntities;
+                    ++NumCulledEntities;
                 }
 
-                BaseRenderList->InsertMesh(*Mesh, Mesh->TransVtxList);
-                ++ProfileInfo.NumEntities;
+                BaseRenderList->InsertMeshParallel(*Mesh, Mesh->TransVtxList);
             }
 
             // Make shadow
             {
-                if (~Mesh->Attr & EMeshAttr::CastShadow || !ShadowMakingLight || !ShadowMakingLight->bActive)
+                if (~Mesh->Attr & EMeshAttr::CastShadow || !bShadows)
+                {
+                    continue;
+                }
+
+                // Casters are rendered into shadow map after all tasks
+                if (bShadowMap)
                 {
+                    PrepareShadowCaster(*Mesh, ShownFrame);
+                    ++NumShadows;
                     continue;
                 }
 
-                // Compute shadow vertex positions
                 const f32 YShadowPosition = World.YShadowPosition;
 
-                VVertex* VtxList = Mesh->TransVtxList;
-                for (i32f i = 0; i < Mesh->NumVtx; ++i)
+                // Shadow is culled by own bounds, mesh itself may be off screen or the other way around
+                if (Mesh->Attr & EMeshAttr::CanBeCulled)
+                {
+                    const f32 Radius = Mesh->MaxRadiusList[VLN_MIN((i32f)ShownFrame, Mesh->NumFrames - 1)];
+                    const VVector3 Min = { Mesh->Position.X - Radius, Mesh->Position.Y - Radius, Mesh->Position.Z - Radius };
+                    const VVector3 Max = { Mesh->Position.X + Radius, Mesh->Position.Y + Radius, Mesh->Position.Z + Radius };
+
+                    VVector3 ShadowMin, ShadowMax;
+                    if (VEntityBVH::ComputeShadowBounds(Min, Max, ShadowMakingLight->Position, YShadowPosition, ShadowMin, ShadowMax) &&
+                        (VEntityBVH::TestBounds(Camera, ShadowMin, ShadowMax) == VEntityBVH::Outside ||
+                         (bOcclusionCulling && OcclusionBuffer.IsOccluded(ShadowMin, ShadowMax))))
+                    {
+                        ++NumCulledShadows;
+                        continue;
+                    }
+                }
+
+                VMesh* Caster = PrepareShadowCaster(*Mesh, ShownFrame);
+
+                // Projected into scratch list of thread, so world vertices of static meshes stay cached
+                ShadowVtxList.Resize(Caster->NumVtx);
+                Memory.MemCopy(ShadowVtxList.GetData(), Caster->TransVtxList, sizeof(VVertex) * Caster->NumVtx);
+
+                VVertex* VtxList = ShadowVtxList.GetData();
+                for (i32f i = 0; i < Caster->NumVtx; ++i)
                 {
                     const VVector4 Direction = (VtxList[i].Position - ShadowMakingLight->Position);
                     const f32 T = (YShadowPosition - ShadowMakingLight->Position.Y) / Direction.Y;
@@ -241,14 +397,43 @@ void VRenderer::Render()
                 }
 
                 // Insert shadow mesh
-                Mesh->State &= ~EMeshState::Culled;
-                BaseRenderList->InsertMesh(*Mesh, Mesh->TransVtxList, &ShadowMaterial);
+                Caster->State &= ~EMeshState::Culled;
+                NumShadowPoly += BaseRenderList->InsertMeshParallel(*Caster, VtxList, &ShadowMaterial, false);
+
+                ++NumShadows;
+            }
+        }
+    });
+
+    BaseRenderList->EndParallelInsert();
 
-                ++ProfileInfo.NumShadows;
+    ProfileInfo.NumEntities += (i32)VisibleEntities.GetLength();
+    ProfileInfo.NumCulledEntities += NumCulledEntities.load();
+    ProfileInfo.NumReducedAnimations += NumReducedAnimations.load();
+    ProfileInfo.NumShadows += NumShadows.load();
+    ProfileInfo.NumCulledShadows += NumCulledShadows.load();
+    ProfileInfo.NumShadowPoly += NumShadowPoly.load();
+
+    // Shadow map is kept while light and casters stay in place
+    if (bShadowMap)
+    {
+        ShadowCasters.Clear();
+        for (const auto Entity : VisibleEntities)
+        {
+            VMesh* Mesh = Entity->Mesh;
+            if (Mesh->Attr & EMeshAttr::CastShadow)
+            {
+                ShadowCasters.EmplaceBack(Mesh->ShadowMesh ? Mesh->ShadowMesh : Mesh);
             }
         }
+
+        ProfileInfo.NumShadowPoly += ShadowMap.Update(*ShadowMakingLight, ShadowCasters);
+        ShadowMap.SetCamera(Camera);
     }
 
+    ProfileInfo.NumAnimatedEntities = PoseCache.GetNumRequests();
+    ProfileInfo.NumAnimatedPoses = PoseCache.GetNumPoses();
+
     // Transform our lights before lighting render lists
     TransformLights(Camera);
 
@@ -266,6 +451,10 @@ void VRenderer::Render()
         RenderLists[i]->TransformWorldToCamera(Camera);
         ProfileInfo.NumClippedPoly += RenderLists[i]->Clip(Camera);
         RenderLists[i]->Light(Camera, World.Lights);
+        if (bShadowMap && !ShadowMap.IsEmpty())
+        {
+            RenderLists[i]->Shadow(ShadowMap, Config.RenderSpec.ShadowIntensity);
+        }
         RenderLists[i]->TransformCameraToScreen(Camera);
     }
 
@@ -276,8 +465,17 @@ void VRenderer::Render()
 
         if (Config.RenderSpec.bRenderSolid)
         {
+            TransparentPolys.Clear();
+
             RenderSolid(BaseRenderList);
             RenderSolid(TerrainRenderList);
+
+            // Shadows go after receivers, so they are depth tested against them
+            RenderShadows(BaseRenderList);
+            ShadowMask.Resolve(Buffer, Pitch, Config.RenderSpec.ShadowIntensity);
+
+            // Sorted back to front, depth is tested but not written
+            RenderTransparent();
         }
         else
         {
@@ -287,70 +485,222 @@ void VRenderer::Render()
     }
 
     ProfileInfo.NumAdditionalPoly = RenderLists[0]->NumAdditionalPoly + RenderLists[1]->NumAdditionalPoly;
+    ProfileInfo.RenderListMemory = RenderLists[0]->GetMemorySize() + RenderLists[1]->GetMemorySize();
+    ProfileInfo.NumGrownRenderListChunks = RenderLists[0]->NumGrownChunks + RenderLists[1]->NumGrownChunks;
+    ProfileInfo.NumDroppedPoly = RenderLists[0]->NumDroppedPoly + RenderLists[1]->NumDroppedPoly;
 
     // Unlock buffer
-    BackSurface.Unlock();
+    BackSurface->Unlock();
 }
 
-void VRenderer::PostProcess()
+VMesh* VRenderer::PrepareShadowCaster(VMesh& Mesh, f32 ShownFrame)
 {
-    if (!Config.RenderSpec.bPostProcessing)
+    if (!Mesh.ShadowMesh)
     {
-        return;
+        return &Mesh;
     }
 
-    if (Config.RenderSpec.PostProcessColorCorrection != Config.RenderSpec.DefaultColorCorrection)
+    // Lower detail shadow mesh is put where mesh is
+    VMesh* Caster = Mesh.ShadowMesh;
+    VLN_ASSERT(Caster->ShadowMeshOwner == &Mesh); // Shared proxies are written by several jobs, use SetShadowMesh()
+    Caster->Position = Mesh.Position;
+    Caster->Rotation = Mesh.Rotation;
+
+    if (Caster->Attr & EMeshAttr::MultiFrame)
     {
-        BackSurface.CorrectColorsFast(Config.RenderSpec.PostProcessColorCorrection);
+        Caster->TransformFrameModelToWorld(VLN_MIN((i32)ShownFrame, Caster->NumFrames - 1));
     }
+    else
+    {
+        Caster->TransformModelToWorld();
+    }
+
+    return Caster;
 }
 
-void VRenderer::RenderUI()
+void VRenderer::PostProcess(VSurface& Surface, const VVector2i& Viewport, const VPresentSettings& Settings)
 {
-    if (!Config.RenderSpec.bRenderUI)
+    if (!Settings.bPostProcessing)
     {
         return;
     }
 
-    ProfileInfo.Display();
-
-    for (const auto& TextElement : TextQueue)
-    {
-        // Render text
-        SDL_Surface* SDLSurface = TTF_RenderText_Solid(Font, TextElement.Text, TextElement.Color);
-        VLN_ASSERT(SDLSurface);
-        SDL_SetColorKey(SDLSurface, SDL_TRUE, static_cast<u32*>(SDLSurface->pixels)[0]);
+    PostProcessChain.Process(Surface, Viewport.X, Viewport.Y, Settings.PostProcess);
+}
 
-        // Convert surface
-        SDL_Surface* SDLConverted = SDL_ConvertSurface(SDLSurface, Config.RenderSpec.SDLPixelFormat, 0);
-        VLN_ASSERT(SDLConverted);
+void VRenderer::RenderUI(VSurface& Surface, const TArray<VTextElement>& Texts)
+{
+    u32* Buffer;
+    i32 Pitch;
+    Surface.Lock(Buffer, Pitch);
 
-        // Blit shadow
-        SDL_Rect Dest = { TextElement.Position.X + TextShadowOffset.X, TextElement.Position.Y + TextShadowOffset.Y, (i32f)std::strlen(TextElement.Text) * FontCharWidth, FontCharHeight };
-        SDL_SetSurfaceColorMod(SDLConverted, 0x00, 0x00, 0x00);
-        SDL_BlitScaled(SDLConverted, nullptr, BackSurface.SDLSurface, &Dest);
+    const i32 Width = Surface.GetWidth();
+    const i32 Height = Surface.GetHeight();
 
-        // Blit text
-        Dest.x -= TextShadowOffset.X;
-        Dest.y -= TextShadowOffset.Y;
-        SDL_SetSurfaceColorMod(SDLConverted, 0xFF, 0xFF, 0xFF);
-        SDL_BlitScaled(SDLConverted, nullptr, BackSurface.SDLSurface, &Dest);
+    for (const auto& TextElement : Texts)
+    {
+        // Draw shadow
+        GlyphAtlas.DrawText(
+            Buffer, Pitch, Width, Height,
+            TextElement.Position.X + TextShadowOffset.X, TextElement.Position.Y + TextShadowOffset.Y,
+            TextElement.Text, MAP_XRGB32(0x00, 0x00, 0x00)
+        );
 
-        // Free memory
-        SDL_FreeSurface(SDLConverted);
-        SDL_FreeSurface(SDLSurface);
+        // Draw text
+        GlyphAtlas.DrawText(
+            Buffer, Pitch, Width, Height,
+            TextElement.Position.X, TextElement.Position.Y,
+            TextElement.Text, TextElement.Color
+        );
     }
+
+    Surface.Unlock();
 }
 
 void VRenderer::PostRender()
 {
-    BackSurface.Blit(nullptr, &VideoSurface, nullptr);
-    SDL_UpdateWindowSurface(Window.SDLWindow);
+    // Profile info is queued here, so it shows numbers of this frame
+    if (Config.RenderSpec.bRenderUI)
+    {
+        ProfileInfo.NumFrameArenaAllocations = FrameArena.GetNumAllocations();
+        ProfileInfo.FrameArenaMemory = (i32)FrameArena.GetNumBytes();
+
+        ProfileInfo.Display();
+    }
+
+    if (bPresentThread)
+    {
+        SubmitFrame();
+    }
+    else
+    {
+        Present(*BackSurface, ViewportSize, TextQueue, CapturePresentSettings());
+        SDL_UpdateWindowSurface(Window.SDLWindow);
+    }
 
     TextQueue.Clear();
     Config.RenderSpec.DebugTextPosition = { 0, 0 };
 }
 
+VRenderer::VPresentSettings VRenderer::CapturePresentSettings() const
+{
+    VPresentSettings Settings;
+    Settings.PostProcess.ColorCorrection = Config.RenderSpec.PostProcessColorCorrection;
+    Settings.bPostProcessing = Config.RenderSpec.bPostProcessing;
+    Settings.bRenderUI = Config.RenderSpec.bRenderUI;
+    Settings.bBilinearUpscale = Config.RenderSpec.bBilinearUpscale;
+
+    return Settings;
+}
+
+void VRenderer::Present(VSurface& Surface, const VVector2i& Viewport, const TArray<VTextElement>& Texts, const VPresentSettings& Settings)
+{
+    PostProcess(Surface, Viewport, Settings);
+    Upscaler.Upscale(Surface, Viewport, VideoSurface, Settings.bBilinearUpscale);
+
+    // UI goes in window resolution, so it's sharp at any render scale
+    if (Settings.bRenderUI)
+    {
+        RenderUI(VideoSurface, Texts);
+    }
+}
+
+void VRenderer::FlipPresentedFrame()
+{
+    if (!bPresentThread)
+    {
+        return;
+    }
+
+    b32 bFlip;
+    {
+        std::lock_guard<std::mutex> Lock(PresentMutex);
+        bFlip = bPresentFlipPending;
+        bPresentFlipPending = false;
+    }
+
+    // Present thread doesn't touch window surface until we submit next frame
+    if (bFlip)
+    {
+        SDL_UpdateWindowSurface(Window.SDLWindow);
+    }
+}
+
+void VRenderer::StartPresentThread()
+{
+    PresentThread = std::thread(&VRenderer::PresentLoop, this);
+}
+
+void VRenderer::StopPresentThread()
+{
+    {
+        std::lock_guard<std::mutex> Lock(PresentMutex);
+        bPresentShutDown = true;
+    }
+    PresentCondition.notify_all();
+
+    PresentThread.join();
+}
+
+void VRenderer::SubmitFrame()
+{
+    // Only one frame can be in flight, so we wait for previous one and show it before handing out the next
+    WaitForPresent();
+    FlipPresentedFrame();
+
+    {
+        std::lock_guard<std::mutex> Lock(PresentMutex);
+
+        PresentSurface = BackSurface;
+        PresentViewportSize = ViewportSize;
+        std::swap(PresentTextQueue, TextQueue);
+        PresentSettings = CapturePresentSettings();
+        bPresentPending = true;
+    }
+    PresentCondition.notify_all();
+
+    // Render next frame into the other surface
+    BackSurfaceIndex = (BackSurfaceIndex + 1) % NumBackSurfaces;
+    BackSurface = &BackSurfaces[BackSurfaceIndex];
+}
+
+void VRenderer::WaitForPresent()
+{
+    if (!bPresentThread)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> Lock(PresentMutex);
+    PresentCondition.wait(Lock, [this]() { return !bPresentPending; });
+}
+
+void VRenderer::PresentLoop()
+{
+    for ( ;; )
+    {
+        {
+            std::unique_lock<std::mutex> Lock(PresentMutex);
+            PresentCondition.wait(Lock, [this]() { return bPresentShutDown || bPresentPending; });
+
+            // Pending frame is dropped on shut down
+            if (bPresentShutDown)
+            {
+                return;
+            }
+        }
+
+        Present(*PresentSurface, PresentViewportSize, PresentTextQueue, PresentSettings);
+
+        {
+            std::lock_guard<std::mutex> Lock(PresentMutex);
+            bPresentPending = false;
+            bPresentFlipPending = true;
+        }
+        PresentCondition.notify_all();
+    }
+}
+
 void VRenderer::DrawLine(u32* Buffer, i32 Pitch, i32 X1, i32 Y1, i32 X2, i32 Y2, u32 Color)
 {
     i32f DX, DY, DX2, DY2, XInc, YInc, Error;
@@ -734,8 +1084,13 @@ void VRenderer::UpdateRenderTargetSize()
     RenderScale = Config.RenderSpec.RenderScale;
     VVector2i NewSize = { (i32)((f32)Config.WindowSpec.DesiredSize.X * RenderScale), (i32)((f32)Config.WindowSpec.DesiredSize.Y * RenderScale) };
 
-    BackSurface.Create(NewSize.X, NewSize.Y);
+    for (i32f i = 0; i < NumBackSurfaces; ++i)
+    {
+        BackSurfaces[i].Create(NewSize.X, NewSize.Y);
+    }
     ZBuffer.Create(NewSize.X, NewSize.Y);
+    ShadowMask.Create(NewSize.X, NewSize.Y);
+    BlendSpanPixels.Resize(NewSize.X);
 
     /* @NOTE:
         Set TargetSize as expected WindowSize, because in fullscreen we couldn't get really 10x10 window size,
@@ -745,13 +1100,110 @@ void VRenderer::UpdateRenderTargetSize()
     */
     Config.WindowSpec.Size = { VideoSurface.Width, VideoSurface.Height };
 
+    // Targets are allocated at RenderScale, dynamic resolution only shrinks viewport
+    DynamicScale = 1.0f;
+    SmoothedWorkTime = 0.0f;
+    DynamicScaleCooldown = 0;
+    SetViewportSize(NewSize);
+
+    VLN_NOTE(hLogRenderer, "New Render Target Size: %dx%d\n", NewSize.X, NewSize.Y);
+}
+
+void VRenderer::UpdateDynamicResolution()
+{
+    static constexpr f32 SmoothFactor = 0.1f;
+    static constexpr f32 UpscaleThreshold = 0.85f; /** Hysteresis, go up only if we have enough headroom */
+    static constexpr f32 MaxStepDown = 0.9f;
+    static constexpr f32 MaxStepUp = 1.05f;
+    static constexpr i32f CooldownFrames = 8; /** Let smoothed time settle after change */
+    static constexpr i32f MinViewportSize = 16;
+
+    if (!Config.RenderSpec.bDynamicResolution)
+    {
+        if (DynamicScale != 1.0f)
+        {
+            DynamicScale = 1.0f;
+            SetViewportSize({ BackSurface->Width, BackSurface->Height });
+        }
+        return;
+    }
+
+    const f32 TargetTime = 1000.0f / (f32)Config.RenderSpec.TargetFPS;
+    SmoothedWorkTime += (Time.GetWorkTime() - SmoothedWorkTime) * SmoothFactor;
+
+    if (DynamicScaleCooldown > 0)
+    {
+        --DynamicScaleCooldown;
+        return;
+    }
+
+    if (SmoothedWorkTime <= 0.0f || (SmoothedWorkTime <= TargetTime && SmoothedWorkTime >= TargetTime * UpscaleThreshold))
+    {
+        return;
+    }
+
+    // Cost goes with number of pixels, so step by square root of time ratio
+    f32 Step = Math.Sqrt(TargetTime / SmoothedWorkTime);
+    Step = VLN_MIN(VLN_MAX(Step, MaxStepDown), MaxStepUp);
+
+    f32 NewScale = DynamicScale * Step;
+    NewScale = VLN_MIN(VLN_MAX(NewScale, Config.RenderSpec.MinDynamicRenderScale), 1.0f);
+
+    if (NewScale == DynamicScale)
+    {
+        return;
+    }
+
+    DynamicScale = NewScale;
+    DynamicScaleCooldown = CooldownFrames;
+
+    VVector2i NewSize = { (i32)((f32)BackSurface->Width * DynamicScale), (i32)((f32)BackSurface->Height * DynamicScale) };
+    NewSize.X = VLN_MIN(VLN_MAX(NewSize.X, MinViewportSize), BackSurface->Width);
+    NewSize.Y = VLN_MIN(VLN_MAX(NewSize.Y, MinViewportSize), BackSurface->Height);
+
+    SetViewportSize(NewSize);
+}
+
+void VRenderer::SetViewportSize(const VVector2i& Size)
+{
+    ViewportSize = Size;
+
     Config.RenderSpec.MinClip = { 0, 0 };
-    Config.RenderSpec.MaxClip = { NewSize.X - 1, NewSize.Y - 1 };
+    Config.RenderSpec.MaxClip = { Size.X - 1, Size.Y - 1 };
 
     Config.RenderSpec.MinClipFloat = { (f32)Config.RenderSpec.MinClip.X, (f32)Config.RenderSpec.MinClip.Y };
     Config.RenderSpec.MaxClipFloat = { (f32)Config.RenderSpec.MaxClip.X, (f32)Config.RenderSpec.MaxClip.Y };
+}
 
-    VLN_NOTE(hLogRenderer, "New Render Target Size: %dx%d\n", NewSize.X, NewSize.Y);
+i32 VRenderer::GetAnimationUpdateInterval(const VMesh& Mesh, const VCamera& Camera) const
+{
+    if (!Config.RenderSpec.bAnimationLOD)
+    {
+        return 1;
+    }
+
+    VVector4 Pos;
+    VMatrix44::MulVecMat(Mesh.Position, Camera.MatCamera, Pos);
+
+    const f32 Radius = Mesh.MaxRadiusList[VLN_MIN((i32f)Mesh.CurrentFrame, Mesh.NumFrames - 1)];
+    if (Pos.Z <= Radius)
+    {
+        return 1;
+    }
+
+    // Projected diameter relative to viewplane height
+    const f32 Size = (2.0f * Radius * Camera.ViewDist) / (Pos.Z * Camera.ViewplaneSize.Y);
+
+    if (Size < Config.RenderSpec.AnimationLODQuarterRateSize || Pos.Z > Config.RenderSpec.AnimationLODQuarterRateDistance)
+    {
+        return 4;
+    }
+    if (Size < Config.RenderSpec.AnimationLODHalfRateSize || Pos.Z > Config.RenderSpec.AnimationLODHalfRateDistance)
+    {
+        return 2;
+    }
+
+    return 1;
 }
 
 void VRenderer::InitFont()
@@ -772,16 +1224,79 @@ void VRenderer::UpdateFont()
     static constexpr f32 PointDivPixel = 0.75f;
     static constexpr f32 QualityMultiplier = 4.0f;
 
-    FontCharWidth = GetScreenWidth() / CharsPerLine;
-    FontCharHeight = GetScreenHeight() / CharsPerRow;
+    // UI is drawn after upscale, so font doesn't depend on render scale
+    FontCharWidth = VideoSurface.Width / CharsPerLine;
+    FontCharHeight = VideoSurface.Height / CharsPerRow;
 
     Font = TTF_OpenFont("Assets/Fonts/Font.ttf", (i32)( (f32)FontCharWidth * PointDivPixel * QualityMultiplier ));
     VLN_ASSERT(Font);
 
-    TextShadowOffset = { (i32)((-1.0f / 640.0f) * (f32)GetScreenWidth()), (i32)((1.0f / 480.0f) * (f32)GetScreenHeight()) };
+    GlyphAtlas.Build(Font, FontCharWidth, FontCharHeight);
+
+    TextShadowOffset = { (i32)((-1.0f / 640.0f) * (f32)VideoSurface.Width), (i32)((1.0f / 480.0f) * (f32)VideoSurface.Height) };
 }
 
+/** Dest = (Src * Alpha + Dest * (256 - Alpha)) / 256 for each channel, 4 pixels at once */
+static void BlendSpan(u32* Dest, const u32* Src, i32f Count, u32 Alpha)
+{
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i SrcWeight = _mm_set1_epi16((i16)Alpha);
+    const __m128i DestWeight = _mm_set1_epi16((i16)(256 - Alpha));
+    const __m128i AlphaMask = _mm_set1_epi32((i32)0xFF000000);
+
+    i32f X = 0;
+    for (; X + 4 <= Count; X += 4)
+    {
+        const __m128i SrcPixels = _mm_loadu_si128((const __m128i*)(Src + X));
+        const __m128i DestPixels = _mm_loadu_si128((const __m128i*)(Dest + X));
+
+        __m128i Low = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(SrcPixels, Zero), SrcWeight),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(DestPixels, Zero), DestWeight)
+        );
+        __m128i High = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpackhi_epi8(SrcPixels, Zero), SrcWeight),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(DestPixels, Zero), DestWeight)
+        );
+        Low = _mm_srli_epi16(Low, 8);
+        High = _mm_srli_epi16(High, 8);
+
+        _mm_storeu_si128((__m128i*)(Dest + X), _mm_or_si128(_mm_packus_epi16(Low, High), AlphaMask));
+    }
+
+    for (; X < Count; ++X)
+    {
+        const u32 SrcPixel = Src[X];
+        const u32 DestPixel = Dest[X];
+
+        const u32 RB = (((SrcPixel & 0x00FF00FF) * Alpha + (DestPixel & 0x00FF00FF) * (256 - Alpha)) >> 8) & 0x00FF00FF;
+        const u32 G = (((SrcPixel & 0x0000FF00) * Alpha + (DestPixel & 0x0000FF00) * (256 - Alpha)) >> 8) & 0x0000FF00;
+
+        Dest[X] = 0xFF000000 | RB | G;
+    }
+}
+
+template<b32 bBlend>
 void VRenderer::DrawTriangle(VInterpolationContext& InterpolationContext)
+{
+    const VVertex* Vtx = InterpolationContext.Vtx;
+
+    const f32 XMin = VLN_MIN(Vtx[0].X, VLN_MIN(Vtx[1].X, Vtx[2].X));
+    const f32 XMax = VLN_MAX(Vtx[0].X, VLN_MAX(Vtx[1].X, Vtx[2].X));
+
+    // Only triangles crossing left or right viewport edge need per span scissoring
+    if (XMin >= Config.RenderSpec.MinClipFloat.X && XMax <= Config.RenderSpec.MaxClipFloat.X)
+    {
+        RasterizeTriangle<bBlend, false>(InterpolationContext);
+    }
+    else
+    {
+        RasterizeTriangle<bBlend, true>(InterpolationContext);
+    }
+}
+
+template<b32 bBlend, b32 bScissor>
+void VRenderer::RasterizeTriangle(VInterpolationContext& InterpolationContext)
 {
     enum class ETriangleCase
     {
@@ -896,6 +1411,11 @@ void VRenderer::DrawTriangle(VInterpolationContext& InterpolationContext)
     fx28 ZDeltaRightByY;
 
     fx28* ZBufferArray;
+    const fx28 ZBias = ZBuffer.Bias; /** Keeps Z unbiased for interpolators */
+
+    // Blended triangle shades span first, hidden pixels keep destination color
+    u32* SpanPixels = bBlend ? BlendSpanPixels.GetData() : nullptr;
+    const u32 Alpha = InterpolationContext.LitColor[0].A + (InterpolationContext.LitColor[0].A >> 7); /** 0-256 */
 
     if (TriangleCase == ETriangleCase::Top ||
         TriangleCase == ETriangleCase::Bottom)
@@ -991,35 +1511,33 @@ void VRenderer::DrawTriangle(VInterpolationContext& InterpolationContext)
         // + 1 because of top-left fill convention
         YEnd = Y2 > Config.RenderSpec.MaxClip.Y ? Config.RenderSpec.MaxClip.Y + 1 : Y2 + 1;
 
-        // Test for clipping X
-        if (X0 < Config.RenderSpec.MinClip.X || X1 < Config.RenderSpec.MinClip.X || X2 < Config.RenderSpec.MinClip.X ||
-            X0 > Config.RenderSpec.MaxClip.X || X1 > Config.RenderSpec.MaxClip.X || X2 > Config.RenderSpec.MaxClip.X)
-        {
-            // Align buffer pointer
-            Buffer += Pitch * YStart;
-            ZBufferArray = (fx28*)ZBuffer.Buffer + (ZBuffer.Pitch * YStart);
+        // Align buffer pointer
+        Buffer += Pitch * YStart;
+        ZBufferArray = (fx28*)ZBuffer.Buffer + (ZBuffer.Pitch * YStart);
 
-            // Process each Y
-            for (InterpolationContext.Y = YStart; InterpolationContext.Y < YEnd; ++InterpolationContext.Y)
-            {
-                // Compute starting values
-                i32f XStart = Fx16ToIntRounded(XLeft);
-                i32f XEnd = Fx16ToIntRounded(XRight) + 1; // X < XEnd in loop so count last pixel
+        // Process each Y
+        for (InterpolationContext.Y = YStart; InterpolationContext.Y < YEnd; ++InterpolationContext.Y)
+        {
+            // Compute starting values
+            i32f XStart = Fx16ToIntRounded(XLeft);
+            i32f XEnd = Fx16ToIntRounded(XRight) + 1; // X < XEnd in loop so count last pixel
 
-                fx16 Z = ZLeft;
-                fx16 ZDeltaByX;
+            fx16 Z = ZLeft;
+            fx16 ZDeltaByX;
 
-                // Compute deltas for X interpolation
-                const i32f XDiff = XEnd - XStart;
+            // Compute deltas for X interpolation
+            const i32f XDiff = XEnd - XStart;
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                {
-                    InterpolationContext.Interpolators[InterpIndex]->ComputeXStartsAndDeltas(InterpolationContext.Interpolators[InterpIndex], XDiff, ZLeft, ZRight);
-                }
+            for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+            {
+                InterpolationContext.Interpolators[InterpIndex]->ComputeXStartsAndDeltas(InterpolationContext.Interpolators[InterpIndex], XDiff, ZLeft, ZRight);
+            }
 
-                ZDeltaByX = XDiff > 0 ? (ZRight - ZLeft) / XDiff : (ZRight - ZLeft); 
+            ZDeltaByX = XDiff > 0 ? (ZRight - ZLeft) / XDiff : (ZRight - ZLeft); 
 
-                // X clipping
+            // Scissor span of triangle crossing viewport edge, it's still inside guard band after VRenderList::Clip()
+            if constexpr (bScissor)
+            {
                 if (XStart < Config.RenderSpec.MinClip.X)
                 {
                     const i32 XDiff = Config.RenderSpec.MinClip.X - XStart;
@@ -1036,127 +1554,67 @@ void VRenderer::DrawTriangle(VInterpolationContext& InterpolationContext)
                 {
                     XEnd = Config.RenderSpec.MaxClip.X + 1;
                 }
+            }
 
-                // Process each X
-                for (i32f X = XStart; X < XEnd; ++X)
+            // Process each X
+            for (i32f X = XStart; X < XEnd; ++X)
+            {
+                if (Z + ZBias > ZBufferArray[X])
                 {
-                    if (Z > ZBufferArray[X])
-                    {
-                        InterpolationContext.Pixel = 0xFFFFFFFF;
-                        InterpolationContext.X = X;
-                        InterpolationContext.Z = Z;
-
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ProcessPixel(InterpolationContext.Interpolators[InterpIndex]);
-                        }
-
-                        Buffer[X] = InterpolationContext.Pixel;
-
-                        ZBufferArray[X] = Z;
-                    }
-
-                    // Interpolate by X
-                    Z += ZDeltaByX;
+                    InterpolationContext.Pixel = 0xFFFFFFFF;
+                    InterpolationContext.X = X;
+                    InterpolationContext.Z = Z;
 
                     for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
                     {
-                        InterpolationContext.Interpolators[InterpIndex]->InterpolateX(InterpolationContext.Interpolators[InterpIndex], 1);
+                        InterpolationContext.Interpolators[InterpIndex]->ProcessPixel(InterpolationContext.Interpolators[InterpIndex]);
                     }
-                }
-
-                // Interpolate by Y
-                XLeft += XDeltaLeftByY;
-                ZLeft += ZDeltaLeftByY;
 
-                XRight += XDeltaRightByY;
-                ZRight += ZDeltaRightByY;
+                    if constexpr (bBlend)
+                    {
+                        SpanPixels[X] = InterpolationContext.Pixel;
+                    }
+                    else
+                    {
+                        Buffer[X] = InterpolationContext.Pixel;
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                {
-                    InterpolationContext.Interpolators[InterpIndex]->InterpolateY(1, 1);
+                        ZBufferArray[X] = Z + ZBias;
+                    }
                 }
-
-                Buffer += Pitch;
-                ZBufferArray += ZBuffer.Pitch;
-            }
-        }
-        else // Non-clipped version
-        {
-            // Align buffer pointer
-            Buffer += Pitch * YStart;
-            ZBufferArray = (fx28*)ZBuffer.Buffer + (ZBuffer.Pitch * YStart);
-
-            // Process each Y
-            for (InterpolationContext.Y = YStart; InterpolationContext.Y < YEnd; ++InterpolationContext.Y)
-            {
-                // Compute starting values
-                const i32f XStart = Fx16ToIntRounded(XLeft);
-                const i32f XEnd = Fx16ToIntRounded(XRight) + 1; // X < XEnd in loop so count last pixel
-
-                fx16 Z = ZLeft;
-                fx16 ZDeltaByX;
-
-                // Compute deltas for X interpolation
-                const i32f XDiff = XEnd - XStart;
-
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+                else if constexpr (bBlend)
                 {
-                    InterpolationContext.Interpolators[InterpIndex]->ComputeXStartsAndDeltas(InterpolationContext.Interpolators[InterpIndex], XDiff, ZLeft, ZRight);
+                    // Hidden pixel is blended with itself
+                    SpanPixels[X] = Buffer[X];
                 }
 
-                if (XDiff > 0)
-                {
-                    ZDeltaByX = (ZRight - ZLeft) / XDiff;
-                }
-                else
-                {
-                    ZDeltaByX = (ZRight - ZLeft);
-                }
+                // Interpolate by X
+                Z += ZDeltaByX;
 
-                // Process each X
-                for (i32f X = XStart; X < XEnd; ++X)
+                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
                 {
-                    if (Z > ZBufferArray[X])
-                    {
-                        InterpolationContext.Pixel = 0xFFFFFFFF;
-                        InterpolationContext.X = X;
-                        InterpolationContext.Z = Z;
-
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ProcessPixel(InterpolationContext.Interpolators[InterpIndex]);
-                        }
-
-                        Buffer[X] = InterpolationContext.Pixel;
-
-                        ZBufferArray[X] = Z;
-                    }
-
-                    // Interpolate by X
-                    Z += ZDeltaByX;
-
-                    for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                    {
-                        InterpolationContext.Interpolators[InterpIndex]->InterpolateX(InterpolationContext.Interpolators[InterpIndex], 1);
-                    }
+                    InterpolationContext.Interpolators[InterpIndex]->InterpolateX(InterpolationContext.Interpolators[InterpIndex], 1);
                 }
+            }
 
-                // Interpolate by Y
-                XLeft += XDeltaLeftByY;
-                ZLeft += ZDeltaLeftByY;
+            if constexpr (bBlend)
+            {
+                BlendSpan(Buffer + XStart, SpanPixels + XStart, XEnd - XStart, Alpha);
+            }
 
-                XRight += XDeltaRightByY;
-                ZRight += ZDeltaRightByY;
+            // Interpolate by Y
+            XLeft += XDeltaLeftByY;
+            ZLeft += ZDeltaLeftByY;
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                {
-                    InterpolationContext.Interpolators[InterpIndex]->InterpolateY(1, 1);
-                }
+            XRight += XDeltaRightByY;
+            ZRight += ZDeltaRightByY;
 
-                Buffer += Pitch;
-                ZBufferArray += ZBuffer.Pitch;
+            for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+            {
+                InterpolationContext.Interpolators[InterpIndex]->InterpolateY(1, 1);
             }
+
+            Buffer += Pitch;
+            ZBufferArray += ZBuffer.Pitch;
         }
     }
     else // General case
@@ -1327,42 +1785,40 @@ void VRenderer::DrawTriangle(VInterpolationContext& InterpolationContext)
             }
         }
 
-        // Test for clipping X
-        if (X0 < Config.RenderSpec.MinClip.X || X1 < Config.RenderSpec.MinClip.X || X2 < Config.RenderSpec.MinClip.X ||
-            X0 > Config.RenderSpec.MaxClip.X || X1 > Config.RenderSpec.MaxClip.X || X2 > Config.RenderSpec.MaxClip.X)
-        {
-            // Align buffer pointer
-            Buffer += Pitch * YStart;
-            ZBufferArray = (fx28*)ZBuffer.Buffer + (ZBuffer.Pitch * YStart);
+        // Align buffer pointer
+        Buffer += Pitch * YStart;
+        ZBufferArray = (fx28*)ZBuffer.Buffer + (ZBuffer.Pitch * YStart);
 
-            // Process each Y
-            for (InterpolationContext.Y = YStart; InterpolationContext.Y < YEnd; ++InterpolationContext.Y)
-            {
-                // Compute starting values
-                i32f XStart = Fx16ToIntRounded(XLeft);
-                i32f XEnd = Fx16ToIntRounded(XRight) + 1; // X < XEnd in loop so count last pixel
+        // Process each Y
+        for (InterpolationContext.Y = YStart; InterpolationContext.Y < YEnd; ++InterpolationContext.Y)
+        {
+            // Compute starting values
+            i32f XStart = Fx16ToIntRounded(XLeft);
+            i32f XEnd = Fx16ToIntRounded(XRight) + 1; // X < XEnd in loop so count last pixel
 
-                fx16 Z = ZLeft;
-                fx16 ZDeltaByX;
+            fx16 Z = ZLeft;
+            fx16 ZDeltaByX;
 
-                // Compute deltas for X interpolation
-                const i32f XDiff = XEnd - XStart;
+            // Compute deltas for X interpolation
+            const i32f XDiff = XEnd - XStart;
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                {
-                    InterpolationContext.Interpolators[InterpIndex]->ComputeXStartsAndDeltas(InterpolationContext.Interpolators[InterpIndex], XDiff, ZLeft, ZRight);
-                }
+            for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+            {
+                InterpolationContext.Interpolators[InterpIndex]->ComputeXStartsAndDeltas(InterpolationContext.Interpolators[InterpIndex], XDiff, ZLeft, ZRight);
+            }
 
-                if (XDiff > 0)
-                {
-                    ZDeltaByX = (ZRight - ZLeft) / XDiff;
-                }
-                else
-                {
-                    ZDeltaByX = (ZRight - ZLeft);
-                }
+            if (XDiff > 0)
+            {
+                ZDeltaByX = (ZRight - ZLeft) / XDiff;
+            }
+            else
+            {
+                ZDeltaByX = (ZRight - ZLeft);
+            }
 
-                // X clipping
+            // Scissor span of triangle crossing viewport edge, it's still inside guard band after VRenderList::Clip()
+            if constexpr (bScissor)
+            {
                 if (XStart < Config.RenderSpec.MinClip.X)
                 {
                     const i32 XDiff = Config.RenderSpec.MinClip.X - XStart;
@@ -1379,244 +1835,236 @@ void VRenderer::DrawTriangle(VInterpolationContext& InterpolationContext)
                 {
                     XEnd = Config.RenderSpec.MaxClip.X + 1;
                 }
+            }
 
-                // Process each X
-                for (i32f X = XStart; X < XEnd; ++X)
+            // Process each X
+            for (i32f X = XStart; X < XEnd; ++X)
+            {
+                if (Z + ZBias > ZBufferArray[X])
                 {
-                    if (Z > ZBufferArray[X])
-                    {
-                        InterpolationContext.Pixel = 0xFFFFFFFF;
-                        InterpolationContext.X = X;
-                        InterpolationContext.Z = Z;
-
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ProcessPixel(InterpolationContext.Interpolators[InterpIndex]);
-                        }
-
-                        Buffer[X] = InterpolationContext.Pixel;
-
-                        ZBufferArray[X] = Z;
-                    }
-
-                    // Interpolate by X
-                    Z += ZDeltaByX;
+                    InterpolationContext.Pixel = 0xFFFFFFFF;
+                    InterpolationContext.X = X;
+                    InterpolationContext.Z = Z;
 
                     for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
                     {
-                        InterpolationContext.Interpolators[InterpIndex]->InterpolateX(InterpolationContext.Interpolators[InterpIndex], 1);
+                        InterpolationContext.Interpolators[InterpIndex]->ProcessPixel(InterpolationContext.Interpolators[InterpIndex]);
                     }
-                }
 
-                // Interpolate by Y
-                XLeft += XDeltaLeftByY;
-                ZLeft += ZDeltaLeftByY;
-
-                XRight += XDeltaRightByY;
-                ZRight += ZDeltaRightByY;
+                    if constexpr (bBlend)
+                    {
+                        SpanPixels[X] = InterpolationContext.Pixel;
+                    }
+                    else
+                    {
+                        Buffer[X] = InterpolationContext.Pixel;
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+                        ZBufferArray[X] = Z + ZBias;
+                    }
+                }
+                else if constexpr (bBlend)
                 {
-                    InterpolationContext.Interpolators[InterpIndex]->InterpolateY(1, 1);
+                    // Hidden pixel is blended with itself
+                    SpanPixels[X] = Buffer[X];
                 }
 
-                Buffer += Pitch;
-                ZBufferArray += ZBuffer.Pitch;
+                // Interpolate by X
+                Z += ZDeltaByX;
 
-                // Test for changing interpolant
-                if (InterpolationContext.Y == YRestartInterpolation)
+                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
                 {
-                    if (bRestartInterpolationAtLeftHand)
-                    {
-                        // Compute new values to get from Y1 to Y2
-                        const i32 YDiff = (Y2 - Y1);
-
-                        XDeltaLeftByY = IntToFx16(X2 - X1) / YDiff;
-                        ZDeltaLeftByY = (ZVtx2 - ZVtx1) / YDiff;
-
-                        XLeft = IntToFx16(X1);
-                        ZLeft = (ZVtx1);
-
-                        // Align down on 1 Y
-                        XLeft += XDeltaLeftByY;
-                        ZLeft += ZDeltaLeftByY;
-
-                        // Do both for interpolators
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ComputeYStartsAndDeltasLeft(InterpolationContext.Interpolators[InterpIndex], YDiff, V1, V2);
-                            InterpolationContext.Interpolators[InterpIndex]->InterpolateYLeft(InterpolationContext.Interpolators[InterpIndex], 1);
-                        }
-                    }
-                    else
-                    {
-                        // Compute new values to get from Y2 to Y1 because we swapped them
-                        const i32 YDiff = (Y1 - Y2);
+                    InterpolationContext.Interpolators[InterpIndex]->InterpolateX(InterpolationContext.Interpolators[InterpIndex], 1);
+                }
+            }
 
-                        XDeltaRightByY = IntToFx16(X1 - X2) / YDiff;
-                        ZDeltaRightByY = (ZVtx1 - ZVtx2) / YDiff;
+            if constexpr (bBlend)
+            {
+                BlendSpan(Buffer + XStart, SpanPixels + XStart, XEnd - XStart, Alpha);
+            }
 
-                        XRight = IntToFx16(X2);
-                        ZRight = (ZVtx2);
+            // Interpolate by Y
+            XLeft += XDeltaLeftByY;
+            ZLeft += ZDeltaLeftByY;
 
-                        // Align down on 1 Y
-                        XRight += XDeltaRightByY;
-                        ZRight += ZDeltaRightByY;
+            XRight += XDeltaRightByY;
+            ZRight += ZDeltaRightByY;
 
-                        // Do both for interpolators
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ComputeYStartsAndDeltasRight(InterpolationContext.Interpolators[InterpIndex], YDiff, V2, V1);
-                            InterpolationContext.Interpolators[InterpIndex]->InterpolateYRight(InterpolationContext.Interpolators[InterpIndex], 1);
-                        }
-                    }
-                }
+            for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+            {
+                InterpolationContext.Interpolators[InterpIndex]->InterpolateY(1, 1);
             }
-        }
-        else // No X clipping
-        {
-            // Align buffer pointer
-            Buffer += Pitch * YStart;
-            ZBufferArray = (fx28*)ZBuffer.Buffer + (ZBuffer.Pitch * YStart);
 
-            // Process each Y
-            for (InterpolationContext.Y = YStart; InterpolationContext.Y < YEnd; ++InterpolationContext.Y)
+            Buffer += Pitch;
+            ZBufferArray += ZBuffer.Pitch;
+
+            // Test for changing interpolant
+            if (InterpolationContext.Y == YRestartInterpolation)
             {
-                // Compute starting values
-                const i32f XStart = Fx16ToIntRounded(XLeft);
-                const i32f XEnd = Fx16ToIntRounded(XRight) + 1; // X < XEnd in loop so count last pixel
+                if (bRestartInterpolationAtLeftHand)
+                {
+                    // Compute new values to get from Y1 to Y2
+                    const i32 YDiff = (Y2 - Y1);
 
-                fx16 Z = ZLeft;
-                fx16 ZDeltaByX;
+                    XDeltaLeftByY = IntToFx16(X2 - X1) / YDiff;
+                    ZDeltaLeftByY = (ZVtx2 - ZVtx1) / YDiff;
 
-                // Compute deltas for X interpolation
-                const i32f XDiff = XEnd - XStart;
+                    XLeft = IntToFx16(X1);
+                    ZLeft = (ZVtx1);
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                {
-                    InterpolationContext.Interpolators[InterpIndex]->ComputeXStartsAndDeltas(InterpolationContext.Interpolators[InterpIndex], XDiff, ZLeft, ZRight);
-                }
+                    // Align down on 1 Y
+                    XLeft += XDeltaLeftByY;
+                    ZLeft += ZDeltaLeftByY;
 
-                if (XDiff > 0)
-                {
-                    ZDeltaByX = (ZRight - ZLeft) / XDiff;
+                    // Do both for interpolators
+                    for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
+                    {
+                        InterpolationContext.Interpolators[InterpIndex]->ComputeYStartsAndDeltasLeft(InterpolationContext.Interpolators[InterpIndex], YDiff, V1, V2);
+                        InterpolationContext.Interpolators[InterpIndex]->InterpolateYLeft(InterpolationContext.Interpolators[InterpIndex], 1);
+                    }
                 }
                 else
                 {
-                    ZDeltaByX = (ZRight - ZLeft);
-                }
+                    // Compute new values to get from Y2 to Y1 because we swapped them
+                    const i32 YDiff = (Y1 - Y2);
 
-                // Process each X
-                for (i32f X = XStart; X < XEnd; ++X)
-                {
-                    if (Z > ZBufferArray[X])
-                    {
-                        InterpolationContext.Pixel = 0xFFFFFFFF;
-                        InterpolationContext.X = X;
-                        InterpolationContext.Z = Z;
-
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ProcessPixel(InterpolationContext.Interpolators[InterpIndex]);
-                        }
-
-                        Buffer[X] = InterpolationContext.Pixel;
+                    XDeltaRightByY = IntToFx16(X1 - X2) / YDiff;
+                    ZDeltaRightByY = (ZVtx1 - ZVtx2) / YDiff;
 
-                        ZBufferArray[X] = Z;
-                    }
+                    XRight = IntToFx16(X2);
+                    ZRight = (ZVtx2);
 
-                    // Interpolate by X
-                    Z += ZDeltaByX;
+                    // Align down on 1 Y
+                    XRight += XDeltaRightByY;
+                    ZRight += ZDeltaRightByY;
 
+                    // Do both for interpolators
                     for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
                     {
-                        InterpolationContext.Interpolators[InterpIndex]->InterpolateX(InterpolationContext.Interpolators[InterpIndex], 1);
+                        InterpolationContext.Interpolators[InterpIndex]->ComputeYStartsAndDeltasRight(InterpolationContext.Interpolators[InterpIndex], YDiff, V2, V1);
+                        InterpolationContext.Interpolators[InterpIndex]->InterpolateYRight(InterpolationContext.Interpolators[InterpIndex], 1);
                     }
                 }
+            }
+        }
+    }
+    
+    ++ProfileInfo.NumRenderedPoly;
+}
 
-                // Interpolate by Y
-                XLeft += XDeltaLeftByY;
-                ZLeft += ZDeltaLeftByY;
+void VRenderer::DrawShadowTriangle(const VVertex* Vtx)
+{
+    const VVertex* P0 = &Vtx[0];
+    const VVertex* P1 = &Vtx[1];
+    const VVertex* P2 = &Vtx[2];
 
-                XRight += XDeltaRightByY;
-                ZRight += ZDeltaRightByY;
+    // Sort by Y
+    const VVertex* Temp;
+    if (P1->Y < P0->Y)
+    {
+        VLN_SWAP(P0, P1, Temp);
+    }
+    if (P2->Y < P0->Y)
+    {
+        VLN_SWAP(P0, P2, Temp);
+    }
+    if (P2->Y < P1->Y)
+    {
+        VLN_SWAP(P1, P2, Temp);
+    }
 
-                for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                {
-                    InterpolationContext.Interpolators[InterpIndex]->InterpolateY(1, 1);
-                }
+    if (P2->Y < Config.RenderSpec.MinClipFloat.Y || P0->Y > Config.RenderSpec.MaxClipFloat.Y)
+    {
+        return;
+    }
 
-                Buffer += Pitch;
-                ZBufferArray += ZBuffer.Pitch;
+    const f32 Area = (P1->X - P0->X) * (P2->Y - P0->Y) - (P2->X - P0->X) * (P1->Y - P0->Y);
+    if (Math.Abs(Area) < Math.Epsilon5)
+    {
+        return;
+    }
 
-                // Test for changing interpolant
-                if (InterpolationContext.Y == YRestartInterpolation)
-                {
-                    if (bRestartInterpolationAtLeftHand)
-                    {
-                        // Compute new values to get from Y1 to Y2
-                        const i32 YDiff = (Y2 - Y1);
+    // 1/z plane in fx28 units, same values which DrawTriangle() writes to z-buffer
+    const f32 Z0 = (f32)(IntToFx28(1) / (i32)(P0->Z + 0.5f));
+    const f32 Z1 = (f32)(IntToFx28(1) / (i32)(P1->Z + 0.5f));
+    const f32 Z2 = (f32)(IntToFx28(1) / (i32)(P2->Z + 0.5f));
 
-                        XDeltaLeftByY = IntToFx16(X2 - X1) / YDiff;
-                        ZDeltaLeftByY = (ZVtx2 - ZVtx1) / YDiff;
+    const f32 InvArea = 1.0f / Area;
+    const f32 ZDX = ((Z1 - Z0) * (P2->Y - P0->Y) - (Z2 - Z0) * (P1->Y - P0->Y)) * InvArea;
+    const f32 ZDY = ((Z2 - Z0) * (P1->X - P0->X) - (Z1 - Z0) * (P2->X - P0->X)) * InvArea;
 
-                        XLeft = IntToFx16(X1);
-                        ZLeft = (ZVtx1);
+    // Pixel centers inside of [Y0, Y2), so every row is crossed by long edge and one of short ones
+    const i32 YStart = VLN_MAX((i32)Math.Ceil(P0->Y - 0.5f), Config.RenderSpec.MinClip.Y);
+    const i32 YEnd = VLN_MIN((i32)Math.Ceil(P2->Y - 0.5f) - 1, Config.RenderSpec.MaxClip.Y);
 
-                        // Align down on 1 Y
-                        XLeft += XDeltaLeftByY;
-                        ZLeft += ZDeltaLeftByY;
+    const fx28 ZBias = ZBuffer.Bias;
 
-                        // Do both for interpolators
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ComputeYStartsAndDeltasLeft(InterpolationContext.Interpolators[InterpIndex], YDiff, V1, V2);
-                            InterpolationContext.Interpolators[InterpIndex]->InterpolateYLeft(InterpolationContext.Interpolators[InterpIndex], 1);
-                        }
-                    }
-                    else
-                    {
-                        // Compute new values to get from Y2 to Y1 because we swapped them
-                        const i32 YDiff = (Y1 - Y2);
+    /**
+        DrawTriangle() snaps vertices to pixels and steps 1/z in fixed point, so coplanar receiver may be
+        up to a pixel of depth slope away from our float plane, plus truncation accumulated along the span
+    */
+    static constexpr f32 ZTruncationTolerance = 1024.0f;
+    const f32 ZTolerance = Math.Abs(ZDX) + Math.Abs(ZDY) + ZTruncationTolerance;
 
-                        XDeltaRightByY = IntToFx16(X1 - X2) / YDiff;
-                        ZDeltaRightByY = (ZVtx1 - ZVtx2) / YDiff;
+    for (i32f Y = YStart; Y <= YEnd; ++Y)
+    {
+        const f32 CenterY = (f32)Y + 0.5f;
 
-                        XRight = IntToFx16(X2);
-                        ZRight = (ZVtx2);
+        f32 XA = P0->X + (CenterY - P0->Y) * (P2->X - P0->X) / (P2->Y - P0->Y);
+        f32 XB = CenterY < P1->Y ?
+            P0->X + (CenterY - P0->Y) * (P1->X - P0->X) / (P1->Y - P0->Y) :
+            P1->X + (CenterY - P1->Y) * (P2->X - P1->X) / (P2->Y - P1->Y);
 
-                        // Align down on 1 Y
-                        XRight += XDeltaRightByY;
-                        ZRight += ZDeltaRightByY;
+        if (XB < XA)
+        {
+            f32 TempFloat;
+            VLN_SWAP(XA, XB, TempFloat);
+        }
 
-                        // Do both for interpolators
-                        for (i32f InterpIndex = 0; InterpIndex < InterpolationContext.NumInterpolators; ++InterpIndex)
-                        {
-                            InterpolationContext.Interpolators[InterpIndex]->ComputeYStartsAndDeltasRight(InterpolationContext.Interpolators[InterpIndex], YDiff, V2, V1);
-                            InterpolationContext.Interpolators[InterpIndex]->InterpolateYRight(InterpolationContext.Interpolators[InterpIndex], 1);
-                        }
-                    }
-                }
-            }
+        const i32 XStart = VLN_MAX((i32)Math.Ceil(XA - 0.5f), Config.RenderSpec.MinClip.X);
+        const i32 XEnd = VLN_MIN((i32)Math.Ceil(XB - 0.5f) - 1, Config.RenderSpec.MaxClip.X);
+
+        if (XStart > XEnd)
+        {
+            continue;
+        }
+
+        const fx28* ZBufferArray = (const fx28*)ZBuffer.Buffer + ZBuffer.Pitch * Y;
+        u8* MaskArray = ShadowMask.Buffer + ShadowMask.Pitch * Y;
+
+        // Shadow is kept where nothing is strictly closer, as when it was drawn before receivers
+        f32 Z = Z0 + ((f32)XStart + 0.5f - P0->X) * ZDX + (CenterY - P0->Y) * ZDY + ZTolerance;
+
+        for (i32f X = XStart; X <= XEnd; ++X)
+        {
+            MaskArray[X] |= (u8)((fx28)Z + ZBias >= ZBufferArray[X]);
+            Z += ZDX;
         }
+
+        ShadowMask.AddSpan(Y, XStart, XEnd);
     }
-    
-    ++ProfileInfo.NumRenderedPoly;
 }
 
 void VRenderer::VarDrawText(i32 X, i32 Y, VColorARGB Color, const char* Format, std::va_list VarList)
 {
-    // Prepare text
-    VTextElement TextElement;
-    std::vsnprintf(TextElement.Text, VTextElement::TextSize, Format, VarList);
+    // Prepare text, first pass only measures it
+    std::va_list MeasureVarList;
+    va_copy(MeasureVarList, VarList);
+    const i32 Length = std::vsnprintf(nullptr, 0, Format, MeasureVarList);
+    va_end(MeasureVarList);
+
+    if (Length < 0)
+    {
+        return;
+    }
 
-    // Convert color
-    TextElement.Color.a = Color.A;
-    TextElement.Color.r = Color.R;
-    TextElement.Color.g = Color.G;
-    TextElement.Color.b = Color.B;
+    char* Text = FrameArena.AllocateArray<char>(Length + 1);
+    std::vsnprintf(Text, Length + 1, Format, VarList);
 
-    // Set position
+    VTextElement TextElement;
+    TextElement.Text = Text;
+
+    // Set color and position
+    TextElement.Color = Color;
     TextElement.Position = { X, Y };
 
     TextQueue.EmplaceBack(std::move(TextElement));
@@ -1647,19 +2095,27 @@ void VRenderer::SetInterpolators()
 {
     InterpolationContext.NumInterpolators = 0;
 
-    if (InterpolationContext.MaterialAttr & EMaterialAttr::ShadeModeGouraud)
-    {
-        InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.GouraudInterpolator;
-    }
-    else if (InterpolationContext.MaterialAttr & EMaterialAttr::ShadeModeFlat)
-    {
-        InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.FlatInterpolator;
-    }
-    else
+    // Palettized texture interpolator is affine and does shading by itself through lit palette, so it's only for distant polygons
+    const b32 bPalettized = InterpolationContext.MaterialAttr & EMaterialAttr::ShadeModeTexture &&
+        InterpolationContext.Material->Texture.IsPalettized() &&
+        InterpolationContext.Distance >= Config.RenderSpec.PalettizedTextureDistance;
+
+    if (!bPalettized)
     {
-        InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.EmissiveInterpolator;
+        if (InterpolationContext.MaterialAttr & EMaterialAttr::ShadeModeGouraud)
+        {
+            InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.GouraudInterpolator;
+        }
+        else if (InterpolationContext.MaterialAttr & EMaterialAttr::ShadeModeFlat)
+        {
+            InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.FlatInterpolator;
+        }
+        else
+        {
+            InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.EmissiveInterpolator;
+        }
+        ++InterpolationContext.NumInterpolators;
     }
-    ++InterpolationContext.NumInterpolators;
 
     if (InterpolationContext.MaterialAttr & EMaterialAttr::ShadeModeTexture)
     {
@@ -1673,7 +2129,11 @@ void VRenderer::SetInterpolators()
                 Distance / (World.Camera->ZFarClip / (f32)MaxMipMaps)
             );
 
-            if (InterpolationContext.MaterialAttr & EMaterialAttr::Terrain)
+            if (bPalettized)
+            {
+                InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.PalettizedTextureInterpolator;
+            }
+            else if (InterpolationContext.MaterialAttr & EMaterialAttr::Terrain)
             {
                 if (Distance < 25000.0f)
                 {
@@ -1708,54 +2168,131 @@ void VRenderer::SetInterpolators()
         else
         {
             InterpolationContext.MipMappingLevel = 0;
-            InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.BilinearPerspectiveTextureInterpolator;
+
+            if (bPalettized)
+            {
+                InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.PalettizedTextureInterpolator;
+            }
+            else
+            {
+                InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.BilinearPerspectiveTextureInterpolator;
+            }
         }
 
         ++InterpolationContext.NumInterpolators;
     }
+}
 
-    if (InterpolationContext.MaterialAttr & EMaterialAttr::Transparent)
+void VRenderer::RenderSolid(const VRenderList* RenderList)
+{
+    for (const i32 PolyIndex : RenderList->GetActivePoly())
     {
-        InterpolationContext.Interpolators[InterpolationContext.NumInterpolators] = &InterpolationContext.AlphaInterpolator;
-        ++InterpolationContext.NumInterpolators;
+        const VPolyFace* Poly = &RenderList->GetPoly(PolyIndex);
+        if (Poly->Material->Attr & EMaterialAttr::Shadow)
+        {
+            continue;
+        }
+
+        // Transparent polygons are drawn after all opaque ones
+        if (Poly->Material->Attr & EMaterialAttr::Transparent)
+        {
+            const f32 Depth = Poly->TransVtx[0].Z + Poly->TransVtx[1].Z + Poly->TransVtx[2].Z;
+            TransparentPolys.EmplaceBack(VTransparentPoly{ ~std::bit_cast<u32>(Depth), Poly });
+            continue;
+        }
+
+        SetPolyInterpolationContext(*Poly);
+        DrawTriangle<false>(InterpolationContext);
     }
 }
 
-void VRenderer::RenderSolid(const VRenderList* RenderList)
+void VRenderer::RenderTransparent()
 {
-    for (i32f i = 0; i < RenderList->NumPoly; ++i)
+    const i32f NumPolys = (i32f)TransparentPolys.GetLength();
+    if (NumPolys == 0)
     {
-        const VPolyFace* Poly = &RenderList->PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
+        return;
+    }
+
+    /* @NOTE:
+        LSD radix sort by 8 bits. Keys are inverted bits of positive depth,
+        so ascending order is back to front
+    */
+    VTransparentPoly* Source = TransparentPolys.GetData();
+    VTransparentPoly* Dest = FrameArena.AllocateArray<VTransparentPoly>(NumPolys);
+
+    for (u32 Shift = 0; Shift < 32; Shift += 8)
+    {
+        i32 Offsets[256] = {};
+        for (i32f i = 0; i < NumPolys; ++i)
+        {
+            ++Offsets[(Source[i].Key >> Shift) & 0xFF];
+        }
+
+        // Every key has the same byte
+        if (Offsets[(Source[0].Key >> Shift) & 0xFF] == NumPolys)
         {
             continue;
         }
 
-        InterpolationContext.Vtx = Poly->TransVtx;
-        InterpolationContext.Material = Poly->Material;
+        i32 Sum = 0;
+        for (i32f Bucket = 0; Bucket < 256; ++Bucket)
+        {
+            const i32 Count = Offsets[Bucket];
+            Offsets[Bucket] = Sum;
+            Sum += Count;
+        }
 
-        InterpolationContext.OriginalColor = Poly->Material->Color;
-        InterpolationContext.LitColor[0] = Poly->LitColor[0];
-        InterpolationContext.LitColor[1] = Poly->LitColor[1];
-        InterpolationContext.LitColor[2] = Poly->LitColor[2];
+        for (i32f i = 0; i < NumPolys; ++i)
+        {
+            Dest[Offsets[(Source[i].Key >> Shift) & 0xFF]++] = Source[i];
+        }
 
-        InterpolationContext.MaterialAttr = Poly->Material->Attr;
-        InterpolationContext.Distance = Poly->TransVtx[0].Z;
+        VTransparentPoly* TempPtr;
+        VLN_SWAP(Source, Dest, TempPtr);
+    }
 
-        Renderer.DrawTriangle(InterpolationContext);
+    for (i32f i = 0; i < NumPolys; ++i)
+    {
+        SetPolyInterpolationContext(*Source[i].Poly);
+        DrawTriangle<true>(InterpolationContext);
     }
 }
 
-void VRenderer::RenderWire(const VRenderList* RenderList)
+void VRenderer::SetPolyInterpolationContext(const VPolyFace& Poly)
 {
-    for (i32f i = 0; i < RenderList->NumPoly; ++i)
+    InterpolationContext.Vtx = Poly.TransVtx;
+    InterpolationContext.Material = Poly.Material;
+
+    InterpolationContext.OriginalColor = Poly.Material->Color;
+    InterpolationContext.LitColor[0] = Poly.LitColor[0];
+    InterpolationContext.LitColor[1] = Poly.LitColor[1];
+    InterpolationContext.LitColor[2] = Poly.LitColor[2];
+
+    InterpolationContext.MaterialAttr = Poly.Material->Attr;
+    InterpolationContext.Distance = Poly.TransVtx[0].Z;
+}
+
+void VRenderer::RenderShadows(const VRenderList* RenderList)
+{
+    for (const i32 PolyIndex : RenderList->GetActivePoly())
     {
-        const VPolyFace* Poly = &RenderList->PolyList[i];
-        if (~Poly->State & EPolyState::Active || Poly->State & EPolyState::NotRenderTest)
+        const VPolyFace* Poly = &RenderList->GetPoly(PolyIndex);
+        if (~Poly->Material->Attr & EMaterialAttr::Shadow)
         {
             continue;
         }
 
+        DrawShadowTriangle(Poly->TransVtx);
+    }
+}
+
+void VRenderer::RenderWire(const VRenderList* RenderList)
+{
+    for (const i32 PolyIndex : RenderList->GetActivePoly())
+    {
+        const VPolyFace* Poly = &RenderList->GetPoly(PolyIndex);
+
         Renderer.DrawClippedLine(
             InterpolationContext.Buffer, InterpolationContext.BufferPitch,
             (i32)Poly->TransVtx[0].X, (i32)Poly->TransVtx[0].Y,
@@ -1781,10 +2318,19 @@ void VRenderer::RenderWire(const VRenderList* RenderList)
 
 void VRenderer::RefreshWindowSurface()
 {
+    WaitForPresent();
+
+    // Presented frame went to the old surface
+    bPresentFlipPending = false;
+
     VideoSurface.SDLSurface = SDL_GetWindowSurface(Window.SDLWindow);
+    VideoSurface.Width = VideoSurface.SDLSurface->w;
+    VideoSurface.Height = VideoSurface.SDLSurface->h;
 
     Config.RenderSpec.SDLPixelFormat = VideoSurface.SDLSurface->format;
     Config.RenderSpec.SDLPixelFormatEnum = Config.RenderSpec.SDLPixelFormat->format;
+
+    UpdateFont();
 }
 
 void VRenderer::VProfileInfo::Display()
@@ -1793,15 +2339,21 @@ void VRenderer::VProfileInfo::Display()
 
     Renderer.DrawDebugText("Profile Info:");
     Renderer.DrawDebugText("  FPS:             %.2f", Time.GetFPS());
+    Renderer.DrawDebugText("  Frame ms p50/99: %.2f/%.2f", Time.GetFrameTimePercentile(50.0f), Time.GetFrameTimePercentile(99.0f));
     Renderer.DrawDebugText("  RenderScale      %.2f", Config.RenderSpec.RenderScale);
+    Renderer.DrawDebugText("  DynamicScale     %.2f (%dx%d)", Renderer.DynamicScale, Renderer.ViewportSize.X, Renderer.ViewportSize.Y);
     Renderer.DrawDebugText("  Entities:        %d", NumEntities);
     Renderer.DrawDebugText("  Active Lights:   %d", NumActiveLights);
-    Renderer.DrawDebugText("  Shadows:         %d", NumShadows);
+    Renderer.DrawDebugText("  Shadows:         %d (%d culled, %d poly)", NumShadows, NumCulledShadows, NumShadowPoly);
     Renderer.DrawDebugText("  Culled Entities: %d", NumCulledEntities);
+    Renderer.DrawDebugText("  Animated Poses:  %d/%d", NumAnimatedPoses, NumAnimatedEntities);
+    Renderer.DrawDebugText("  Reduced Anims:   %d", NumReducedAnimations);
     Renderer.DrawDebugText("  Backfaced Poly:  %d", NumBackfacedPoly);
     Renderer.DrawDebugText("  Clipped Poly:    %d", NumClippedPoly);
     Renderer.DrawDebugText("  Additional Poly: %d", NumAdditionalPoly);
     Renderer.DrawDebugText("  Rendered Poly:   %d", NumRenderedPoly);
+    Renderer.DrawDebugText("  Render Lists:    %d KB (+%d chunks, %d dropped)", RenderListMemory / 1024, NumGrownRenderListChunks, NumDroppedPoly);
+    Renderer.DrawDebugText("  Frame Arena:     %d KB (%d allocs)", FrameArenaMemory / 1024, NumFrameArenaAllocations);
 }
 
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "SDL.h"
 #include "SDL_ttf.h"
 #include "Common/Types/Common.h"
@@ -11,12 +14,20 @@
 #include "Common/Math/Vector.h"
 #include "Common/Math/Fixed16.h"
 #include "Engine/Core/Config/Config.h"
+#include "Engine/Core/JobSystem.h"
 #include "Engine/Graphics/Types/Color.h"
 #include "Engine/Graphics/Types/Polygon.h"
 #include "Engine/Graphics/Scene/Light.h"
 #include "Engine/Graphics/Scene/Camera.h"
+#include "Engine/Graphics/Scene/PoseCache.h"
 #include "Engine/Graphics/Rendering/Surface.h"
 #include "Engine/Graphics/Rendering/ZBuffer.h"
+#include "Engine/Graphics/Rendering/ShadowMask.h"
+#include "Engine/Graphics/Rendering/ShadowMap.h"
+#include "Engine/Graphics/Rendering/OcclusionBuffer.h"
+#include "Engine/Graphics/Rendering/GlyphAtlas.h"
+#include "Engine/Graphics/Rendering/PostProcess.h"
+#include "Engine/Graphics/Rendering/Upscaler.h"
 #include "Engine/Graphics/Rendering/RenderList.h"
 #include "Engine/Graphics/Rendering/InterpolationContext.h"
 
@@ -28,9 +39,8 @@ class VRenderList;
 class VRenderer
 {
 public:
-    static constexpr i32f MaxBaseRenderListPoly    = 524'288;
-    static constexpr i32f MaxTerrainRenderListPoly = 524'288;
-    static constexpr i32f MaxCachedRenderListPoly  = MaxTerrainRenderListPoly;
+    /** One is rendered while the other one is presented */
+    static constexpr i32f NumBackSurfaces = 2;
 
 private:
     struct VProfileInfo
@@ -38,11 +48,21 @@ private:
         i32 NumEntities;
         i32 NumActiveLights;
         i32 NumShadows;
+        i32 NumCulledShadows;
+        i32 NumShadowPoly;
         i32 NumCulledEntities;
+        i32 NumAnimatedEntities;
+        i32 NumAnimatedPoses;
+        i32 NumReducedAnimations;
         i32 NumBackfacedPoly;
         i32 NumClippedPoly;
         i32 NumAdditionalPoly;
         i32 NumRenderedPoly;
+        i32 RenderListMemory; /** Bytes */
+        i32 NumGrownRenderListChunks;
+        i32 NumDroppedPoly;
+        i32 NumFrameArenaAllocations;
+        i32 FrameArenaMemory; /** Bytes */
 
         VLN_FINLINE void Reset()
         {
@@ -54,34 +74,85 @@ private:
 
     struct VTextElement
     {
-        static constexpr i32f TextSize = 512;
-
-        char Text[TextSize];
-        SDL_Color Color;
+        const char* Text; /** In frame arena */
+        VColorARGB Color;
         VVector2i Position;
     };
 
 private:
     VSurface VideoSurface;
-    VSurface BackSurface;
+    VSurface BackSurfaces[NumBackSurfaces];
+    VSurface* BackSurface; /** Current render target */
+    i32 BackSurfaceIndex;
 
     f32 RenderScale;
 
+    /** Part of back surface we render to, top left aligned. Smaller than surface with dynamic resolution */
+    VVector2i ViewportSize;
+    f32 DynamicScale;
+    f32 SmoothedWorkTime;
+    i32 DynamicScaleCooldown;
+
+    u32 FrameIndex; /** Staggers reduced rate animation updates */
+
     VRenderList* BaseRenderList;
     VRenderList* TerrainRenderList;
 
     VZBuffer ZBuffer;
+    VShadowMask ShadowMask; /** Planar shadows of current frame */
+    VOcclusionBuffer OcclusionBuffer; /** Terrain occluders for entity culling */
     VInterpolationContext InterpolationContext;
 
     VMaterial ShadowMaterial;
 
+    /** Sort key is inverted bits of positive depth, so ascending order is back to front */
+    struct VTransparentPoly
+    {
+        u32 Key;
+        const VPolyFace* Poly;
+    };
+    TArray<VTransparentPoly> TransparentPolys; /** Collected by RenderSolid() */
+    TArray<u32> BlendSpanPixels; /** Shaded span of blended triangle, render target width */
+    VPoseCache PoseCache; /** Animated poses of current frame */
+    TArray<VVertex> ShadowVtxLists[VJobSystem::MaxThreads]; /** Projected shadow of current mesh of each thread */
+    VShadowMap ShadowMap;
+    TArray<VMesh*> ShadowCasters; /** Visible casters of current frame for shadow map */
+
+    VPostProcessChain PostProcessChain;
+    VColorCorrectionPass ColorCorrectionPass;
+
+    VUpscaler Upscaler;
+
     TTF_Font* Font;
     i32 FontCharWidth; /** In pixels */
     i32 FontCharHeight;
+    VGlyphAtlas GlyphAtlas; /** Rebuilt with font */
 
     VVector2i TextShadowOffset;
     TArray<VTextElement> TextQueue;
 
+    /** Render specification values used by Present(), copied with frame so present thread never reads Config */
+    struct VPresentSettings
+    {
+        VPostProcessSettings PostProcess;
+        b8 bPostProcessing;
+        b8 bRenderUI;
+        b8 bBilinearUpscale;
+    };
+
+    /** Present thread post processes, upscales and draws UI of previous frame while we render the next one, main thread flips it */
+    std::thread PresentThread;
+    std::mutex PresentMutex;
+    std::condition_variable PresentCondition;
+    VSurface* PresentSurface;
+    VVector2i PresentViewportSize;
+    TArray<VTextElement> PresentTextQueue;
+    VPresentSettings PresentSettings;
+    b32 bPresentThread;
+    b32 bPresentPending;
+    b32 bPresentFlipPending; /** Window surface holds presented frame which isn't shown yet */
+    b32 bPresentShutDown;
+
     VProfileInfo ProfileInfo;
 
 public:
@@ -117,21 +188,55 @@ public:
 
 private:
     void UpdateRenderTargetSize();
+    void UpdateDynamicResolution();
+    void SetViewportSize(const VVector2i& Size);
+
+    /** 1 for full rate animation, 2 or 4 if mesh is far or small on screen */
+    i32 GetAnimationUpdateInterval(const VMesh& Mesh, const VCamera& Camera) const;
+
+    /** Returns mesh which casts shadow for given one, shadow mesh is moved to it and set to ShownFrame */
+    VMesh* PrepareShadowCaster(VMesh& Mesh, f32 ShownFrame);
 
     void InitFont();
     void UpdateFont();
 
+    /** Blended triangle tests depth without writing it and mixes spans with alpha of LitColor[0] */
+    template<b32 bBlend>
     void DrawTriangle(VInterpolationContext& InterpolationContext);
+
+    /** Spans are scissored by viewport only if bScissor, otherwise triangle must be inside it */
+    template<b32 bBlend, b32 bScissor>
+    void RasterizeTriangle(VInterpolationContext& InterpolationContext);
+
+    /** Marks pixels of screen space triangle in shadow mask where it passes depth test, writes neither depth nor color */
+    void DrawShadowTriangle(const VVertex* Vtx);
     void VarDrawText(i32 X, i32 Y, VColorARGB Color, const char* Format, std::va_list VarList); 
 
     void PreRender();
     void Render();
-    void PostProcess();
-    void RenderUI();
+    void PostProcess(VSurface& Surface, const VVector2i& Viewport, const VPresentSettings& Settings);
+    void RenderUI(VSurface& Surface, const TArray<VTextElement>& Texts);
     void PostRender();
 
+    VPresentSettings CapturePresentSettings() const;
+
+    /** Post process, upscale and UI into window surface, caller flips it */
+    void Present(VSurface& Surface, const VVector2i& Viewport, const TArray<VTextElement>& Texts, const VPresentSettings& Settings);
+
+    /** Shows frame finished by present thread if there is one, window is updated only from main thread */
+    void FlipPresentedFrame();
+
+    void StartPresentThread();
+    void StopPresentThread();
+    void SubmitFrame();
+    void WaitForPresent(); /** Must be called before touching surfaces, font or window from main thread */
+    void PresentLoop();
+
     void SetInterpolators();
+    void SetPolyInterpolationContext(const VPolyFace& Poly);
     void RenderSolid(const VRenderList* RenderList);
+    void RenderTransparent();
+    void RenderShadows(const VRenderList* RenderList);
     void RenderWire(const VRenderList* RenderList);
 
 public:
@@ -148,9 +253,9 @@ inline VRenderer Renderer;
 VLN_FINLINE void VRenderer::PutPixel(u32* Buffer, i32 Pitch, i32 X, i32 Y, u32 Color) const
 {
     VLN_ASSERT(X >= 0);
-    VLN_ASSERT(X < BackSurface.Width);
+    VLN_ASSERT(X < BackSurface->Width);
     VLN_ASSERT(Y >= 0);
-    VLN_ASSERT(Y < BackSurface.Height);
+    VLN_ASSERT(Y < BackSurface->Height);
 
     Buffer[Y*Pitch + X] = Color;
 }
@@ -165,7 +270,7 @@ VLN_FINLINE void VRenderer::DrawClippedLine(u32* Buffer, i32 Pitch, i32 X1, i32
 
 VLN_FINLINE i32 VRenderer::GetScreenWidth() const
 {
-    return BackSurface.Width;
+    return ViewportSize.X;
 }
 
 VLN_FINLINE i32 VRenderer::GetFontCharWidth() const
@@ -180,12 +285,13 @@ VLN_FINLINE i32 VRenderer::GetFontCharHeight() const
 
 VLN_FINLINE i32 VRenderer::GetScreenHeight() const
 {
-    return BackSurface.Height;
+    return ViewportSize.Y;
 }
 
 VLN_FINLINE void VRenderer::RemoveTerrain()
 {
     TerrainRenderList->ResetList();
+    OcclusionBuffer.RemoveOccluders();
 }
 
 }
@@ -0,0 +1,244 @@
+#include "Common/Math/Math.h"
+#include "Common/Platform/Memory.h"
+#include "Engine/Graphics/Rendering/DepthRasterizer.h"
+#include "Engine/Graphics/Rendering/ShadowMap.h"
+
+namespace Volition
+{
+
+i32 VShadowMap::Update(const VLight& Light, const TArray<VMesh*>& Casters)
+{
+    // Placement of light and casters, animated casters don't keep world vertices so they are always rendered
+    u64 Hash = 14695981039346656037ull;
+    b32 bCacheable = true;
+
+    const auto HashBytes = [&Hash](const void* Data, VSizeType Count)
+    {
+        const u8* Bytes = (const u8*)Data;
+        for (VSizeType i = 0; i < Count; ++i)
+        {
+            Hash = (Hash ^ Bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    HashBytes(&Light.Position, sizeof(Light.Position));
+
+    for (const VMesh* Caster : Casters)
+    {
+        if (~Caster->State & EMeshState::WorldVtxCached)
+        {
+            bCacheable = false;
+            break;
+        }
+
+        HashBytes(&Caster, sizeof(Caster));
+        HashBytes(&Caster->CachedPosition, sizeof(Caster->CachedPosition));
+        HashBytes(&Caster->CachedRotation, sizeof(Caster->CachedRotation));
+        HashBytes(&Caster->CachedFrame, sizeof(Caster->CachedFrame));
+    }
+
+    if (bCacheable && bCacheValid && Hash == CasterHash)
+    {
+        return 0;
+    }
+
+    LightPosition = Light.Position;
+    const i32 NumTriangles = Render(Casters);
+
+    CasterHash = Hash;
+    bCacheValid = bCacheable;
+
+    return NumTriangles;
+}
+
+void VShadowMap::SetCamera(const VCamera& Camera)
+{
+    VMatrix44::Inverse(Camera.MatCamera, MatCameraToWorld);
+}
+
+f32 VShadowMap::GetShadow(const VVector4& CameraPosition) const
+{
+    VVector4 Position;
+    VMatrix44::MulVecMat(CameraPosition, MatCameraToWorld, Position);
+
+    const f32 Depth = LightPosition.Y - Position.Y;
+    if (Depth < MinDepth)
+    {
+        return 0.0f;
+    }
+
+    const f32 InvDepth = 1.0f / Depth;
+
+    // Sample 2x2 texels around point with bilinear weights
+    const f32 X = ((Position.X - LightPosition.X) * InvDepth - UMin) * UScale - 0.5f;
+    const f32 Y = ((Position.Z - LightPosition.Z) * InvDepth - VMin) * VScale - 0.5f;
+
+    if (X < -1.0f || Y < -1.0f || X >= (f32)Size || Y >= (f32)Size)
+    {
+        return 0.0f;
+    }
+
+    const f32 FloorX = Math.Floor(X);
+    const f32 FloorY = Math.Floor(Y);
+    const f32 FracX = X - FloorX;
+    const f32 FracY = Y - FloorY;
+
+    const i32 X0 = (i32)FloorX;
+    const i32 Y0 = (i32)FloorY;
+
+    // Caster is closer than receiver by bias
+    const f32 ShadowedInvDepth = InvDepth * (1.0f + DepthBias);
+
+    const auto Test = [this, ShadowedInvDepth](i32 TX, i32 TY) -> f32
+    {
+        if (TX < 0 || TY < 0 || TX >= Size || TY >= Size)
+        {
+            return 0.0f;
+        }
+
+        return Buffer[TY * Size + TX] > ShadowedInvDepth ? 1.0f : 0.0f;
+    };
+
+    return
+        (Test(X0, Y0) * (1.0f - FracX) + Test(X0 + 1, Y0) * FracX) * (1.0f - FracY) +
+        (Test(X0, Y0 + 1) * (1.0f - FracX) + Test(X0 + 1, Y0 + 1) * FracX) * FracY;
+}
+
+i32 VShadowMap::Render(const TArray<VMesh*>& Casters)
+{
+    Clear();
+    bRendered = false;
+
+    // Project every caster vertex on plane under light with unit distance
+    VSizeType NumVtx = 0;
+    for (const VMesh* Caster : Casters)
+    {
+        NumVtx += Caster->NumVtx;
+    }
+    ProjectedVtx.Resize(NumVtx);
+
+    b32 bAnyProjected = false;
+    f32 UMax = 0.0f, VMax = 0.0f;
+
+    VVector3* Projected = ProjectedVtx.GetData();
+    for (const VMesh* Caster : Casters)
+    {
+        for (i32f VtxIndex = 0; VtxIndex < Caster->NumVtx; ++VtxIndex, ++Projected)
+        {
+            const VVector4& Position = Caster->TransVtxList[VtxIndex].Position;
+            const f32 Depth = LightPosition.Y - Position.Y;
+
+            if (Depth < MinDepth)
+            {
+                Projected->Z = 0.0f;
+                continue;
+            }
+
+            Projected->Z = 1.0f / Depth;
+            Projected->X = (Position.X - LightPosition.X) * Projected->Z;
+            Projected->Y = (Position.Z - LightPosition.Z) * Projected->Z;
+
+            if (!bAnyProjected)
+            {
+                UMin = UMax = Projected->X;
+                VMin = VMax = Projected->Y;
+                bAnyProjected = true;
+            }
+            else
+            {
+                UMin = VLN_MIN(UMin, Projected->X);
+                UMax = VLN_MAX(UMax, Projected->X);
+                VMin = VLN_MIN(VMin, Projected->Y);
+                VMax = VLN_MAX(VMax, Projected->Y);
+            }
+        }
+    }
+
+    if (!bAnyProjected)
+    {
+        return 0;
+    }
+
+    // Fit window to casters with texel of border, so lookups outside of it find nothing
+    static constexpr f32 Border = 1.0f;
+    const f32 UExtent = VLN_MAX(UMax - UMin, Math.Epsilon5);
+    const f32 VExtent = VLN_MAX(VMax - VMin, Math.Epsilon5);
+
+    UScale = ((f32)Size - 2.0f * Border) / UExtent;
+    VScale = ((f32)Size - 2.0f * Border) / VExtent;
+    UMin -= Border / UScale;
+    VMin -= Border / VScale;
+
+    for (auto& Vtx : ProjectedVtx)
+    {
+        Vtx.X = (Vtx.X - UMin) * UScale;
+        Vtx.Y = (Vtx.Y - VMin) * VScale;
+    }
+
+    // Depth only, both faces, same SIMD rasterizer as occlusion buffer without its conservative rules
+    i32 NumTriangles = 0;
+    const VVector3* CasterVtx = ProjectedVtx.GetData();
+
+    for (const VMesh* Caster : Casters)
+    {
+        for (i32f PolyIndex = 0; PolyIndex < Caster->NumPoly; ++PolyIndex)
+        {
+            const VPoly& Poly = Caster->PolyList[PolyIndex];
+
+            const VVector3 Triangle[3] = {
+                CasterVtx[Poly.VtxIndices[0]],
+                CasterVtx[Poly.VtxIndices[1]],
+                CasterVtx[Poly.VtxIndices[2]]
+            };
+
+            if (Triangle[0].Z == 0.0f || Triangle[1].Z == 0.0f || Triangle[2].Z == 0.0f)
+            {
+                continue;
+            }
+
+            VDepthRasterBounds Bounds;
+            if (VDepthRasterizer::RasterizeTriangle(Buffer, Size, Size, Triangle, 0, false, Bounds))
+            {
+                for (i32f Y = Bounds.Y0; Y <= Bounds.Y1; ++Y)
+                {
+                    DirtyXBegin[Y] = VLN_MIN(DirtyXBegin[Y], Bounds.X0);
+                    DirtyXEnd[Y] = VLN_MAX(DirtyXEnd[Y], Bounds.X1);
+                }
+            }
+            ++NumTriangles;
+        }
+
+        CasterVtx += Caster->NumVtx;
+    }
+
+    bRendered = true;
+
+    return NumTriangles;
+}
+
+void VShadowMap::Clear()
+{
+    if (!bDirtyValid)
+    {
+        Memory.MemSetQuad(Buffer, 0, Size * Size);
+    }
+    else
+    {
+        for (i32f Y = 0; Y < Size; ++Y)
+        {
+            if (DirtyXBegin[Y] <= DirtyXEnd[Y])
+            {
+                Memory.MemSetQuad(Buffer + Y * Size + DirtyXBegin[Y], 0, DirtyXEnd[Y] - DirtyXBegin[Y] + 1);
+            }
+        }
+    }
+
+    for (i32f Y = 0; Y < Size; ++Y)
+    {
+        DirtyXBegin[Y] = Size;
+        DirtyXEnd[Y] = -1;
+    }
+    bDirtyValid = true;
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Math/Vector.h"
+#include "Common/Math/Matrix.h"
+#include "Common/Platform/Platform.h"
+#include "Engine/Graphics/Scene/Camera.h"
+#include "Engine/Graphics/Scene/Light.h"
+#include "Engine/Graphics/Scene/Mesh.h"
+
+namespace Volition
+{
+
+/**
+    Low resolution depth map of shadow casters, seen from point light looking down.
+    Map is projection onto plane under light, window is fitted to casters,
+    and it's rendered again only if light or any caster has moved
+*/
+class VShadowMap
+{
+public:
+    static constexpr i32f Size = 512;
+
+    /** Receiver is shadowed if caster is closer to light by this part of receiver distance */
+    static constexpr f32 DepthBias = 0.01f;
+
+    /** Vertices closer to light plane are not projected */
+    static constexpr f32 MinDepth = 1.0f;
+
+private:
+    f32 Buffer[Size * Size]; /** 1/depth under light, 0 is empty */
+
+    /** Span of every row written by last Render(), only it is cleared for the next one */
+    i32 DirtyXBegin[Size];
+    i32 DirtyXEnd[Size];
+    b32 bDirtyValid = false; /** False if whole buffer has to be cleared */
+
+    TArray<VVector3> ProjectedVtx; /** Map X, Y and 1/depth of caster vertices, 0 if can't be projected */
+
+    VPoint4 LightPosition;
+    f32 UMin = 0.0f, VMin = 0.0f;
+    f32 UScale = 0.0f, VScale = 0.0f;
+
+    u64 CasterHash = 0;
+    b32 bCacheValid = false; /** False if some caster was animated */
+    b32 bRendered = false;   /** False if there was nothing to render */
+
+    VMatrix44 MatCameraToWorld;
+
+public:
+    /** Renders casters if light or casters changed since last call, returns number of rasterized triangles */
+    i32 Update(const VLight& Light, const TArray<VMesh*>& Casters);
+
+    /** Sets camera which space receivers are given in */
+    void SetCamera(const VCamera& Camera);
+
+    /** Part of 2x2 samples around camera space point which is in shadow, from 0 to 1 */
+    f32 GetShadow(const VVector4& CameraPosition) const;
+
+    VLN_FINLINE b32 IsEmpty() const
+    {
+        return !bRendered;
+    }
+
+private:
+    /** Returns number of rasterized triangles */
+    i32 Render(const TArray<VMesh*>& Casters);
+
+    /** Zeroes spans written by last Render() */
+    void Clear();
+};
+
+}
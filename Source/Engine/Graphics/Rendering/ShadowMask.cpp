@@ -0,0 +1,56 @@
+#include "Engine/Core/JobSystem.h"
+#include "Engine/Graphics/Rendering/ShadowMask.h"
+
+namespace Volition
+{
+
+void VShadowMask::Resolve(u32* ColorBuffer, i32 ColorPitch, f32 Intensity)
+{
+    if (IsEmpty())
+    {
+        return;
+    }
+
+    // 8 bit fraction of color which stays, applied to red and blue at once
+    const f32 ClampedIntensity = VLN_MIN(VLN_MAX(Intensity, 0.0f), 1.0f);
+    const u32 Keep = (u32)((1.0f - ClampedIntensity) * 256.0f + 0.5f);
+
+    JobSystem.ParallelFor(MaxY - MinY + 1, 32, [&](i32 Begin, i32 End)
+    {
+        for (i32f Y = MinY + Begin; Y < MinY + End; ++Y)
+        {
+            const i32 XStart = RowMinX[Y];
+            const i32 XEnd = RowMaxX[Y];
+
+            if (XStart > XEnd)
+            {
+                continue;
+            }
+
+            u8* Mask = Buffer + Y * Pitch;
+            u32* Pixels = ColorBuffer + Y * ColorPitch;
+
+            for (i32f X = XStart; X <= XEnd; ++X)
+            {
+                if (Mask[X])
+                {
+                    const u32 Pixel = Pixels[X];
+                    const u32 RB = (((Pixel & 0x00FF00FF) * Keep) >> 8) & 0x00FF00FF;
+                    const u32 G = (((Pixel & 0x0000FF00) * Keep) >> 8) & 0x0000FF00;
+
+                    Pixels[X] = (Pixel & 0xFF000000) | RB | G;
+                }
+            }
+
+            Memory.MemSetByte(Mask + XStart, 0, XEnd - XStart + 1);
+
+            RowMinX[Y] = Width;
+            RowMaxX[Y] = -1;
+        }
+    });
+
+    MinY = Height;
+    MaxY = -1;
+}
+
+}
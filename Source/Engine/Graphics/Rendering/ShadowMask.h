@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Platform/Platform.h"
+#include "Common/Platform/Memory.h"
+
+namespace Volition
+{
+
+/**
+    Per pixel byte mask for planar shadows, sized like VZBuffer.
+    Shadow triangles only mark pixels, then Resolve() darkens each marked pixel once,
+    so overlapping shadow polygons cost one byte store instead of full shading
+*/
+class VShadowMask
+{
+public:
+    u8* Buffer = nullptr;
+    i32 Pitch = 0;
+    i32 Width = 0;
+    i32 Height = 0;
+
+private:
+    TArray<u8> Storage;
+
+    /** Marked span of every row, empty if min is greater than max */
+    TArray<i32> RowMinX;
+    TArray<i32> RowMaxX;
+
+    /** Marked rows, empty if min is greater than max */
+    i32 MinY = 0;
+    i32 MaxY = -1;
+
+public:
+    void Create(i32 InWidth, i32 InHeight)
+    {
+        Width = InWidth;
+        Height = InHeight;
+        Pitch = InWidth;
+
+        Storage.Resize(Pitch * Height);
+        Buffer = Storage.GetData();
+        Memory.MemSetByte(Buffer, 0, Pitch * Height);
+
+        RowMinX.Resize(Height);
+        RowMaxX.Resize(Height);
+        for (i32f Y = 0; Y < Height; ++Y)
+        {
+            RowMinX[Y] = Width;
+            RowMaxX[Y] = -1;
+        }
+
+        MinY = Height;
+        MaxY = -1;
+    }
+
+    void Destroy()
+    {
+        Storage.Clear();
+        RowMinX.Clear();
+        RowMaxX.Clear();
+
+        Buffer = nullptr;
+        Pitch = Width = Height = 0;
+
+        MinY = 0;
+        MaxY = -1;
+    }
+
+    /** Extends marked span of row from XStart to XEnd inclusive, pixels themselves are written to Buffer by rasterizer */
+    VLN_FINLINE void AddSpan(i32 Y, i32 XStart, i32 XEnd)
+    {
+        RowMinX[Y] = VLN_MIN(RowMinX[Y], XStart);
+        RowMaxX[Y] = VLN_MAX(RowMaxX[Y], XEnd);
+
+        MinY = VLN_MIN(MinY, Y);
+        MaxY = VLN_MAX(MaxY, Y);
+    }
+
+    VLN_FINLINE b32 IsEmpty() const
+    {
+        return MinY > MaxY;
+    }
+
+    /** Scales marked pixels of color buffer by (1 - Intensity) and clears marked spans */
+    void Resolve(u32* ColorBuffer, i32 ColorPitch, f32 Intensity);
+};
+
+}
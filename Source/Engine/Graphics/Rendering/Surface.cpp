@@ -1,4 +1,5 @@
 #include "SDL_image.h"
+#include "Engine/Core/JobSystem.h"
 #include "Engine/Graphics/Rendering/Renderer.h"
 #include "Engine/Graphics/Rendering/Surface.h"
 
@@ -36,7 +37,22 @@ void VSurface::Create(i32 InWidth, i32 InHeight)
     Height = SDLSurface->h;
 }
 
-void VSurface::Load(const char* Path, u32 SDLPixelFormat)
+void VSurface::Create(u32* InPixels, i32 InWidth, i32 InHeight)
+{
+    Destroy();
+
+    SDL_Surface* PlatformSurface = SDL_CreateRGBSurfaceWithFormatFrom(
+        InPixels, InWidth, InHeight, Config.RenderSpec.BitsPerPixel,
+        InWidth * Config.RenderSpec.BytesPerPixel, Config.RenderSpec.SDLPixelFormatEnum
+    );
+    VLN_ASSERT(PlatformSurface);
+
+    SDLSurface = PlatformSurface;
+    Width = SDLSurface->w;
+    Height = SDLSurface->h;
+}
+
+void VSurface::Load(const char* Path, u32 SDLPixelFormat, SDL_Surface** OutSource)
 {
     Destroy();
 
@@ -47,7 +63,15 @@ void VSurface::Load(const char* Path, u32 SDLPixelFormat)
         Temp, SDLPixelFormat, 0
     );
     VLN_ASSERT(Converted);
-    SDL_FreeSurface(Temp);
+
+    if (OutSource)
+    {
+        *OutSource = Temp;
+    }
+    else
+    {
+        SDL_FreeSurface(Temp);
+    }
 
     Create(Converted);
 }
@@ -117,6 +141,23 @@ void VSurface::CorrectColorsFast(const VVector3& ColorCorrection)
     Unlock();
 }
 
+void VSurface::CorrectColors(const VColorLUT& LUT)
+{
+    u32* Buffer;
+    i32 Pitch;
+    Lock(Buffer, Pitch);
+
+    JobSystem.ParallelFor(Height, 32, [&](i32 Begin, i32 End)
+    {
+        for (i32f Y = Begin; Y < End; ++Y)
+        {
+            LUT.ApplyRow(Buffer + Y * Pitch, Width);
+        }
+    });
+
+    Unlock();
+}
+
 void VSurface::SetAlphaMode(b32 bMode)
 {
     if (SDLSurface)
@@ -7,6 +7,7 @@
 #include "Common/Platform/Platform.h"
 #include "Common/Platform/Assert.h"
 #include "Engine/Core/Config/Config.h"
+#include "Engine/Graphics/Types/ColorLUT.h"
 
 namespace Volition
 {
@@ -30,8 +31,10 @@ public:
 
     void Create(i32 InWidth, i32 InHeight);
     void Create(SDL_Surface* InSDLSurface);
+    void Create(u32* InPixels, i32 InWidth, i32 InHeight); /** Wraps external pixels, they must outlive surface */
 
-    void Load(const char* Path, u32 SDLPixelFormat);
+    /** If OutSource is set, unconverted image is handed to caller who frees it */
+    void Load(const char* Path, u32 SDLPixelFormat, SDL_Surface** OutSource = nullptr);
 
     VLN_FINLINE void Load(const char* Path)
     {
@@ -46,6 +49,7 @@ public:
     /** For textures */
     void CorrectColorsSlow(const VVector3& ColorCorrection = { 1.0f, 1.0f, 1.0f });
     void CorrectColorsFast(const VVector3& ColorCorrection = { 1.0f, 1.0f, 1.0f });
+    void CorrectColors(const VColorLUT& LUT); /** Table lookup, rows are split between job threads */
 
     void SetAlphaMode(b32 bMode);
 
@@ -62,6 +66,7 @@ public:
     void FillRect(VRelativeRectInt* Rect, u32 Color);
 
     friend class VRenderer;
+    friend class VUpscaler;
 };
 
 VLN_FINLINE void VSurface::Lock(u32*& OutBuffer, i32& OutPitch)
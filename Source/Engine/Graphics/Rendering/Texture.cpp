@@ -1,9 +1,107 @@
+#include <emmintrin.h>
+#include <cstdio>
+#include <filesystem>
+#include "Engine/Core/JobSystem.h"
 #include "Engine/Graphics/Rendering/Renderer.h"
 #include "Engine/Graphics/Rendering/Texture.h"
 
 namespace Volition
 {
 
+VLN_DEFINE_LOG_CHANNEL(hLogTexture, "Texture");
+
+static constexpr const char* TextureCacheDirectory = "Cache/Textures";
+static constexpr u32 TextureCacheMagic = 0x43545856; // "VTXC"
+static constexpr u32 TextureCacheVersion = 2;
+static constexpr i32f TextureCacheAlignment = 16;
+static constexpr i32f MaxCachedMipMaps = 16;
+
+/** Cache file is this header followed by mip levels with tightly packed rows */
+struct VTextureCacheHeader
+{
+    u32 Magic;
+    u32 Version;
+
+    // Key, cache is stale if anything here changes
+    u32 PixelFormat;
+    i32 MaxMipMaps;
+    VVector3 ColorCorrection;
+    i32 bWantPalettized;
+    i64 SourceWriteTime;
+    u64 SourceSize;
+
+    i32 NumMipMaps;
+    i32 bPalettized;
+    u32 PaletteOffset;
+    struct
+    {
+        i32 Width;
+        i32 Height;
+        u32 Offset;
+        u32 IndexedOffset;
+    } Levels[MaxCachedMipMaps];
+};
+
+static constexpr u32 InvalidLitPaletteKey = 0xFFFFFFFF;
+
+static VLN_FINLINE f32 CountersToMs(u64 Counters)
+{
+    return (f32)((f64)Counters * 1000.0 / (f64)SDL_GetPerformanceFrequency());
+}
+
+static VLN_FINLINE u32 AlignCacheOffset(u32 Offset)
+{
+    return (Offset + TextureCacheAlignment - 1) & ~(u32)(TextureCacheAlignment - 1);
+}
+
+b32 VTexture::MakeCacheKey(const char* Path, const VVector3& ColorCorrection, i32 MaxMipMaps, VTextureCacheHeader& OutKey, char (&OutCachePath)[512])
+{
+    std::error_code Error;
+
+    const auto SourceWriteTime = std::filesystem::last_write_time(Path, Error);
+    if (Error)
+    {
+        return false;
+    }
+
+    const u64 SourceSize = (u64)std::filesystem::file_size(Path, Error);
+    if (Error)
+    {
+        return false;
+    }
+
+    Memory.MemSetByte(&OutKey, 0, sizeof(OutKey));
+    OutKey.Magic = TextureCacheMagic;
+    OutKey.Version = TextureCacheVersion;
+    OutKey.PixelFormat = Config.RenderSpec.SDLPixelFormatEnum;
+    OutKey.MaxMipMaps = MaxMipMaps;
+    OutKey.ColorCorrection = ColorCorrection;
+    OutKey.bWantPalettized = Config.RenderSpec.bPalettizedTextures;
+    OutKey.SourceWriteTime = (i64)SourceWriteTime.time_since_epoch().count();
+    OutKey.SourceSize = SourceSize;
+
+    // FNV-1a of correction key, so the same image loaded with different settings gets own file
+    u32 Hash = 2166136261u;
+    const u8* KeyBytes = (const u8*)&OutKey.PixelFormat;
+    const VSizeType KeySize = sizeof(OutKey.PixelFormat) + sizeof(OutKey.MaxMipMaps) + sizeof(OutKey.ColorCorrection) + sizeof(OutKey.bWantPalettized);
+    for (VSizeType i = 0; i < KeySize; ++i)
+    {
+        Hash = (Hash ^ KeyBytes[i]) * 16777619u;
+    }
+
+    char Name[256];
+    i32f Length = 0;
+    for ( ; Path[Length] && Length < (i32f)sizeof(Name) - 1; ++Length)
+    {
+        const char C = Path[Length];
+        Name[Length] = (C == '/' || C == '\\' || C == '.' || C == ':') ? '_' : C;
+    }
+    Name[Length] = '\0';
+
+    std::snprintf(OutCachePath, sizeof(OutCachePath), "%s/%s_%08X.vtc", TextureCacheDirectory, Name, Hash);
+    return true;
+}
+
 void VTexture::Load(const char* Path, const VVector3& ColorCorrection, i32 MaxMipMaps)
 {
     Destroy();
@@ -12,13 +110,63 @@ void VTexture::Load(const char* Path, const VVector3& ColorCorrection, i32 MaxMi
     {
         MaxMipMaps = Config.RenderSpec.MaxMipMaps;
     }
+    MaxMipMaps = VLN_MIN(MaxMipMaps, (i32)MaxCachedMipMaps);
+
+    const u64 StartCounter = SDL_GetPerformanceCounter();
 
     Surfaces.Resize(MaxMipMaps);
-    Surfaces[0].Load(Path);
 
-    Surfaces[0].CorrectColorsSlow(ColorCorrection);
+    VTextureCacheHeader Key;
+    char CachePath[512];
+    const b32 bCacheable = Config.RenderSpec.bTextureCache && MakeCacheKey(Path, ColorCorrection, MaxMipMaps, Key, CachePath);
+
+    if (bCacheable && LoadFromCache(CachePath, Key))
+    {
+        for (i32f i = 0; i < NumMipMaps; ++i)
+        {
+            u32* DummyBuffer;
+            i32 DummyPitch;
+
+            Surfaces[i].Lock(DummyBuffer, DummyPitch);
+        }
+
+        VLN_NOTE(
+            hLogTexture, "%s %dx%d, %d mips%s: mapped from cache in %.2f ms\n",
+            Path, Surfaces[0].GetWidth(), Surfaces[0].GetHeight(), NumMipMaps, bPalettized ? ", palettized" : "",
+            CountersToMs(SDL_GetPerformanceCounter() - StartCounter)
+        );
+
+        bLoaded = true;
+        return;
+    }
+
+    SDL_Surface* Source = nullptr;
+    Surfaces[0].Load(Path, Config.RenderSpec.SDLPixelFormatEnum, Config.RenderSpec.bPalettizedTextures ? &Source : nullptr);
+
+    const u64 DecodedCounter = SDL_GetPerformanceCounter();
+
+    const VColorLUT LUT(ColorCorrection);
+    if (ColorCorrection != VRenderSpecification::DefaultColorCorrection)
+    {
+        Surfaces[0].CorrectColors(LUT);
+    }
+
+    const u64 CorrectedCounter = SDL_GetPerformanceCounter();
+
     GenerateMipMaps(MaxMipMaps);
 
+    if (Source)
+    {
+        if (Source->format->BitsPerPixel == 8 && Source->format->palette)
+        {
+            GenerateIndexedLevels(Source, LUT);
+        }
+
+        SDL_FreeSurface(Source);
+    }
+
+    const u64 EndCounter = SDL_GetPerformanceCounter();
+
     for (i32f i = 0; i < NumMipMaps; ++i)
     {
         u32* DummyBuffer;
@@ -27,6 +175,19 @@ void VTexture::Load(const char* Path, const VVector3& ColorCorrection, i32 MaxMi
         Surfaces[i].Lock(DummyBuffer, DummyPitch);
     }
 
+    VLN_NOTE(
+        hLogTexture, "%s %dx%d, %d mips%s: decode %.2f ms, correction %.2f ms, mips %.2f ms\n",
+        Path, Surfaces[0].GetWidth(), Surfaces[0].GetHeight(), NumMipMaps, bPalettized ? ", palettized" : "",
+        CountersToMs(DecodedCounter - StartCounter),
+        CountersToMs(CorrectedCounter - DecodedCounter),
+        CountersToMs(EndCounter - CorrectedCounter)
+    );
+
+    if (bCacheable)
+    {
+        SaveToCache(CachePath, Key);
+    }
+
     bLoaded = true;
 }
 
@@ -43,6 +204,13 @@ void VTexture::Destroy()
         Surfaces[i].Destroy();
     }
 
+    IndexedLevels.Clear();
+    IndexedStorage.Clear();
+    LitPalettes.Clear();
+    bPalettized = false;
+
+    CacheFile.Close();
+
     bLoaded = false;
 }
 
@@ -60,6 +228,51 @@ const VSurface& VTexture::Get(i32 MipMaps) const
     return Surfaces[MipMaps];
 }
 
+const u8* VTexture::GetIndexed(i32 MipMaps) const
+{
+    VLN_ASSERT(bPalettized);
+
+    if (MipMaps < 0)
+    {
+        MipMaps = 0;
+    }
+    else if (MipMaps >= NumMipMaps)
+    {
+        MipMaps = NumMipMaps - 1;
+    }
+
+    return IndexedLevels[MipMaps];
+}
+
+const VColorARGB* VTexture::GetLitPalette(VColorARGB LitColor) const
+{
+    VLN_ASSERT(bPalettized);
+
+    // 5 bits per channel is a light level, finer steps aren't noticeable between neighbour polygons
+    const u32 Key = ((LitColor.R >> 3) << 10) | ((LitColor.G >> 3) << 5) | (LitColor.B >> 3);
+    VLitPalette& LitPalette = LitPalettes[((Key * 2654435761u) >> 16) & (NumLitPaletteSlots - 1)];
+
+    if (LitPalette.Key != Key)
+    {
+        LitPalette.Key = Key;
+
+        const i32 R = ((Key >> 10) & 31) * 255 / 31;
+        const i32 G = ((Key >> 5) & 31) * 255 / 31;
+        const i32 B = (Key & 31) * 255 / 31;
+
+        for (i32f i = 0; i < PaletteSize; ++i)
+        {
+            LitPalette.Colors[i] = MAP_XRGB32(
+                Palette[i].R * R / 255,
+                Palette[i].G * G / 255,
+                Palette[i].B * B / 255
+            );
+        }
+    }
+
+    return LitPalette.Colors;
+}
+
 
 void VTexture::GenerateMipMaps(i32 MaxMipMaps)
 {
@@ -85,59 +298,353 @@ void VTexture::GenerateMipMaps(i32 MaxMipMaps)
         i32 PrevPitch;
         Surfaces[i - 1].Lock(PrevBuffer, PrevPitch);
 
-        for (i32f Y = 0; Y < CurrentSize.Y; ++Y)
+        // Current size is floored, so 2x2 block never leaves previous level
+        JobSystem.ParallelFor(CurrentSize.Y, 16, [&](i32 Begin, i32 End)
         {
-            for (i32f X = 0; X < CurrentSize.X; ++X)
+            for (i32f Y = Begin; Y < End; ++Y)
             {
-                const i32 PrevPixelY0 = (Y * 2) * PrevPitch;
-                i32 PrevPixelY1 = PrevPixelY0 + PrevPitch;
-                if (PrevPixelY1 > (PrevSize.Y * PrevPitch))
+                DownsampleRow(
+                    CurrentBuffer + Y * CurrentPitch,
+                    PrevBuffer + (Y * 2) * PrevPitch,
+                    PrevBuffer + (Y * 2 + 1) * PrevPitch,
+                    CurrentSize.X
+                );
+            }
+        });
+
+        Surfaces[i - 1].Unlock();
+        Surfaces[i].Unlock();
+    }
+}
+
+void VTexture::GenerateIndexedLevels(const SDL_Surface* Source, const VColorLUT& LUT)
+{
+    const SDL_Palette* SourcePalette = Source->format->palette;
+    for (i32f i = 0; i < PaletteSize; ++i)
+    {
+        if (i < SourcePalette->ncolors)
+        {
+            const SDL_Color& Color = SourcePalette->colors[i];
+            Palette[i] = LUT.Apply(MAP_XRGB32(Color.r, Color.g, Color.b));
+        }
+        else
+        {
+            Palette[i] = VColorARGB::Black;
+        }
+    }
+
+    VSizeType StorageSize = 0;
+    for (i32f i = 0; i < NumMipMaps; ++i)
+    {
+        StorageSize += Surfaces[i].GetWidth() * Surfaces[i].GetHeight();
+    }
+
+    IndexedStorage.Resize(StorageSize);
+    IndexedLevels.Resize(NumMipMaps);
+
+    // Base level is taken as is
+    u8* Indices = IndexedStorage.GetData();
+    {
+        const i32 Width = Surfaces[0].GetWidth();
+        const i32 Height = Surfaces[0].GetHeight();
+
+        for (i32f Y = 0; Y < Height; ++Y)
+        {
+            Memory.MemCopy(Indices + Y * Width, (const u8*)Source->pixels + Y * Source->pitch, Width);
+        }
+
+        IndexedLevels[0] = Indices;
+        Indices += Width * Height;
+    }
+
+    // Filtered levels are mapped back to the nearest palette entry through 15-bit inverse table
+    if (NumMipMaps > 1)
+    {
+        TArray<u8> InversePalette;
+        InversePalette.Resize(32768);
+
+        JobSystem.ParallelFor(32768, 1024, [&](i32 Begin, i32 End)
+        {
+            for (i32f Key = Begin; Key < End; ++Key)
+            {
+                const i32 R = ((Key >> 10) & 31) * 255 / 31;
+                const i32 G = ((Key >> 5) & 31) * 255 / 31;
+                const i32 B = (Key & 31) * 255 / 31;
+
+                i32 BestIndex = 0;
+                i32 BestDistance = 0x7FFFFFFF;
+
+                for (i32f i = 0; i < PaletteSize; ++i)
                 {
-                    PrevPixelY1 = PrevPixelY0;
+                    const i32 DR = Palette[i].R - R;
+                    const i32 DG = Palette[i].G - G;
+                    const i32 DB = Palette[i].B - B;
+                    const i32 Distance = DR * DR + DG * DG + DB * DB;
+
+                    if (Distance < BestDistance)
+                    {
+                        BestDistance = Distance;
+                        BestIndex = (i32)i;
+                    }
                 }
 
-                const i32 PrevPixelX0 = (X * 2);
-                i32 PrevPixelX1 = PrevPixelX0 + 1;
-                if (PrevPixelX1 > PrevSize.X)
+                InversePalette[Key] = (u8)BestIndex;
+            }
+        });
+
+        for (i32f i = 1; i < NumMipMaps; ++i)
+        {
+            u32* Buffer;
+            i32 Pitch;
+            Surfaces[i].Lock(Buffer, Pitch);
+
+            const i32 Width = Surfaces[i].GetWidth();
+            const i32 Height = Surfaces[i].GetHeight();
+
+            for (i32f Y = 0; Y < Height; ++Y)
+            {
+                for (i32f X = 0; X < Width; ++X)
                 {
-                    PrevPixelX1 = PrevPixelX0;
+                    const VColorARGB Color = Buffer[Y * Pitch + X];
+                    Indices[Y * Width + X] = InversePalette[((Color.R >> 3) << 10) | ((Color.G >> 3) << 5) | (Color.B >> 3)];
                 }
-
-                const VColorARGB PrevPixels[4] = {
-                    PrevBuffer[PrevPixelY0 + PrevPixelX0],
-                    PrevBuffer[PrevPixelY0 + PrevPixelX1],
-                    PrevBuffer[PrevPixelY1 + PrevPixelX0],
-                    PrevBuffer[PrevPixelY1 + PrevPixelX1]
-                };
-
-                VColorARGB FilteredPixel;
-                FilteredPixel.R = (
-                    PrevPixels[0].R +
-                    PrevPixels[1].R +
-                    PrevPixels[2].R +
-                    PrevPixels[3].R
-                ) >> 2; // Divide by 4
-
-                FilteredPixel.G = (
-                    PrevPixels[0].G +
-                    PrevPixels[1].G +
-                    PrevPixels[2].G +
-                    PrevPixels[3].G
-                ) >> 2; // Divide by 4
-
-                FilteredPixel.B = (
-                    PrevPixels[0].B +
-                    PrevPixels[1].B +
-                    PrevPixels[2].B +
-                    PrevPixels[3].B
-                ) >> 2; // Divide by 4
-
-                CurrentBuffer[Y * CurrentPitch + X] = FilteredPixel;
             }
+
+            Surfaces[i].Unlock();
+
+            IndexedLevels[i] = Indices;
+            Indices += Width * Height;
         }
+    }
 
-        Surfaces[i - 1].Unlock();
-        Surfaces[i].Unlock();
+    LitPalettes.Resize(NumLitPaletteSlots);
+    for (i32f i = 0; i < NumLitPaletteSlots; ++i)
+    {
+        LitPalettes[i].Key = InvalidLitPaletteKey;
+    }
+
+    bPalettized = true;
+}
+
+b32 VTexture::LoadFromCache(const char* CachePath, const VTextureCacheHeader& Key)
+{
+    if (!CacheFile.Open(CachePath))
+    {
+        return false;
+    }
+
+    VTextureCacheHeader Header;
+    const u8* Data = CacheFile.GetData();
+    const VSizeType Size = CacheFile.GetSize();
+
+    b32 bValid = Size >= sizeof(Header);
+    if (bValid)
+    {
+        Memory.MemCopy(&Header, Data, sizeof(Header));
+
+        bValid =
+            Header.Magic == Key.Magic &&
+            Header.Version == Key.Version &&
+            Header.PixelFormat == Key.PixelFormat &&
+            Header.MaxMipMaps == Key.MaxMipMaps &&
+            Header.ColorCorrection == Key.ColorCorrection &&
+            Header.bWantPalettized == Key.bWantPalettized &&
+            Header.SourceWriteTime == Key.SourceWriteTime &&
+            Header.SourceSize == Key.SourceSize &&
+            Header.NumMipMaps > 0 && Header.NumMipMaps <= Key.MaxMipMaps;
+    }
+
+    for (i32f i = 0; bValid && i < Header.NumMipMaps; ++i)
+    {
+        const u64 LevelEnd = (u64)Header.Levels[i].Offset + (u64)Header.Levels[i].Width * Header.Levels[i].Height * sizeof(u32);
+        bValid = Header.Levels[i].Width > 0 && Header.Levels[i].Height > 0 && LevelEnd <= Size;
+
+        if (bValid && Header.bPalettized)
+        {
+            const u64 IndexedEnd = (u64)Header.Levels[i].IndexedOffset + (u64)Header.Levels[i].Width * Header.Levels[i].Height;
+            bValid = IndexedEnd <= Size && (u64)Header.PaletteOffset + sizeof(Palette) <= Size;
+        }
+    }
+
+    if (!bValid)
+    {
+        VLN_WARNING(hLogTexture, "Stale or broken cache %s, rebuilding\n", CachePath);
+        CacheFile.Close();
+        return false;
+    }
+
+    NumMipMaps = Header.NumMipMaps;
+    for (i32f i = 0; i < NumMipMaps; ++i)
+    {
+        Surfaces[i].Create((u32*)(Data + Header.Levels[i].Offset), Header.Levels[i].Width, Header.Levels[i].Height);
+    }
+
+    if (Header.bPalettized)
+    {
+        Memory.MemCopy(Palette, Data + Header.PaletteOffset, sizeof(Palette));
+
+        IndexedLevels.Resize(NumMipMaps);
+        for (i32f i = 0; i < NumMipMaps; ++i)
+        {
+            IndexedLevels[i] = Data + Header.Levels[i].IndexedOffset;
+        }
+
+        LitPalettes.Resize(NumLitPaletteSlots);
+        for (i32f i = 0; i < NumLitPaletteSlots; ++i)
+        {
+            LitPalettes[i].Key = InvalidLitPaletteKey;
+        }
+
+        bPalettized = true;
+    }
+
+    return true;
+}
+
+void VTexture::SaveToCache(const char* CachePath, const VTextureCacheHeader& Key) const
+{
+    std::error_code Error;
+    std::filesystem::create_directories(TextureCacheDirectory, Error);
+
+    std::FILE* File = std::fopen(CachePath, "wb");
+    if (!File)
+    {
+        VLN_WARNING(hLogTexture, "Can't write texture cache %s\n", CachePath);
+        return;
+    }
+
+    VTextureCacheHeader Header = Key;
+    Header.NumMipMaps = NumMipMaps;
+    Header.bPalettized = bPalettized;
+
+    u32 Offset = AlignCacheOffset(sizeof(Header));
+    for (i32f i = 0; i < NumMipMaps; ++i)
+    {
+        Header.Levels[i].Width = Surfaces[i].GetWidth();
+        Header.Levels[i].Height = Surfaces[i].GetHeight();
+        Header.Levels[i].Offset = Offset;
+
+        Offset = AlignCacheOffset(Offset + Surfaces[i].GetWidth() * Surfaces[i].GetHeight() * sizeof(u32));
+    }
+
+    if (bPalettized)
+    {
+        Header.PaletteOffset = Offset;
+        Offset = AlignCacheOffset(Offset + sizeof(Palette));
+
+        for (i32f i = 0; i < NumMipMaps; ++i)
+        {
+            Header.Levels[i].IndexedOffset = Offset;
+            Offset = AlignCacheOffset(Offset + Surfaces[i].GetWidth() * Surfaces[i].GetHeight());
+        }
+    }
+
+    b32 bWritten = true;
+    u32 Written = 0;
+
+    const auto Write = [&](u32 At, const void* Data, VSizeType Size)
+    {
+        static constexpr u8 Padding[TextureCacheAlignment] = {};
+
+        if (bWritten && At > Written)
+        {
+            bWritten = std::fwrite(Padding, 1, At - Written, File) == At - Written;
+        }
+        if (bWritten)
+        {
+            bWritten = std::fwrite(Data, 1, Size, File) == Size;
+        }
+
+        Written = At + (u32)Size;
+    };
+
+    Write(0, &Header, sizeof(Header));
+
+    for (i32f i = 0; i < NumMipMaps; ++i)
+    {
+        const u32* Buffer = Surfaces[i].GetBuffer();
+        const i32 Pitch = Surfaces[i].GetPitch();
+        const i32 RowSize = Header.Levels[i].Width * sizeof(u32);
+
+        for (i32f Y = 0; Y < Header.Levels[i].Height; ++Y)
+        {
+            Write(Header.Levels[i].Offset + Y * RowSize, Buffer + Y * Pitch, RowSize);
+        }
+    }
+
+    if (bPalettized)
+    {
+        Write(Header.PaletteOffset, Palette, sizeof(Palette));
+
+        for (i32f i = 0; i < NumMipMaps; ++i)
+        {
+            Write(Header.Levels[i].IndexedOffset, IndexedLevels[i], Header.Levels[i].Width * Header.Levels[i].Height);
+        }
+    }
+
+    std::fclose(File);
+
+    if (!bWritten)
+    {
+        VLN_WARNING(hLogTexture, "Can't write texture cache %s\n", CachePath);
+        std::remove(CachePath);
+    }
+}
+
+void VTexture::DownsampleRow(u32* Dest, const u32* SourceRow0, const u32* SourceRow1, i32 DestWidth)
+{
+    i32f X = 0;
+
+#if VLN_SSE
+    // 4 destination pixels from 8x2 source pixels, channels are summed in 16 bits
+    const __m128i Zero = _mm_setzero_si128();
+
+    for ( ; X + 4 <= DestWidth; X += 4)
+    {
+        const __m128i Top0    = _mm_loadu_si128((const __m128i*)(SourceRow0 + X * 2));
+        const __m128i Top1    = _mm_loadu_si128((const __m128i*)(SourceRow0 + X * 2 + 4));
+        const __m128i Bottom0 = _mm_loadu_si128((const __m128i*)(SourceRow1 + X * 2));
+        const __m128i Bottom1 = _mm_loadu_si128((const __m128i*)(SourceRow1 + X * 2 + 4));
+
+        // Vertical sums, 2 pixels per register
+        const __m128i Sum0 = _mm_add_epi16(_mm_unpacklo_epi8(Top0, Zero), _mm_unpacklo_epi8(Bottom0, Zero));
+        const __m128i Sum1 = _mm_add_epi16(_mm_unpackhi_epi8(Top0, Zero), _mm_unpackhi_epi8(Bottom0, Zero));
+        const __m128i Sum2 = _mm_add_epi16(_mm_unpacklo_epi8(Top1, Zero), _mm_unpacklo_epi8(Bottom1, Zero));
+        const __m128i Sum3 = _mm_add_epi16(_mm_unpackhi_epi8(Top1, Zero), _mm_unpackhi_epi8(Bottom1, Zero));
+
+        // Horizontal sums of neighbour pixels, then divide by 4
+        const __m128i Result01 = _mm_srli_epi16(
+            _mm_add_epi16(_mm_unpacklo_epi64(Sum0, Sum1), _mm_unpackhi_epi64(Sum0, Sum1)), 2
+        );
+        const __m128i Result23 = _mm_srli_epi16(
+            _mm_add_epi16(_mm_unpacklo_epi64(Sum2, Sum3), _mm_unpackhi_epi64(Sum2, Sum3)), 2
+        );
+
+        _mm_storeu_si128((__m128i*)(Dest + X), _mm_packus_epi16(Result01, Result23));
+    }
+#endif
+
+    for ( ; X < DestWidth; ++X)
+    {
+        const VColorARGB Pixels[4] = {
+            SourceRow0[X * 2],
+            SourceRow0[X * 2 + 1],
+            SourceRow1[X * 2],
+            SourceRow1[X * 2 + 1]
+        };
+
+        VColorARGB FilteredPixel;
+        for (i32f Channel = 0; Channel < 4; ++Channel)
+        {
+            FilteredPixel.C[Channel] = (u8)((
+                Pixels[0].C[Channel] +
+                Pixels[1].C[Channel] +
+                Pixels[2].C[Channel] +
+                Pixels[3].C[Channel]
+            ) >> 2); // Divide by 4
+        }
+
+        Dest[X] = FilteredPixel;
     }
 }
 
@@ -1,17 +1,44 @@
 #pragma once
 
 #include "Common/Types/Array.h"
+#include "Engine/Core/MappedFile.h"
+#include "Engine/Graphics/Types/Color.h"
 #include "Engine/Graphics/Rendering/Surface.h"
 
 namespace Volition
 {
 
+struct VTextureCacheHeader;
+
 class VTexture
 {
+public:
+    static constexpr i32f PaletteSize = 256;
+    static constexpr i32f NumLitPaletteSlots = 64;
+
+private:
+    /** Palette modulated by quantized lit color */
+    struct VLitPalette
+    {
+        u32 Key;
+        VColorARGB Colors[PaletteSize];
+    };
+
+private:
     TArray<VSurface> Surfaces;
     i32 NumMipMaps;
 
+    /** Optional 8-bit copy of mip chain, rows are tightly packed */
+    TArray<const u8*> IndexedLevels;
+    TArray<u8> IndexedStorage;
+    VColorARGB Palette[PaletteSize];
+    mutable TArray<VLitPalette> LitPalettes;
+
+    /** Backs surfaces if texture came from cache */
+    VMappedFile CacheFile;
+
     b8 bLoaded = false;
+    b8 bPalettized = false;
 
 public:
     void Load(const char* Path, const VVector3& ColorCorrection = { 1.0f, 1.0f, 1.0f }, i32 MaxMipMaps = -1);
@@ -19,8 +46,29 @@ public:
 
     const VSurface& Get(i32 MipMaps) const;
 
+    VLN_FINLINE b32 IsPalettized() const
+    {
+        return bPalettized;
+    }
+
+    /** Indices of mip level, pitch is equal to width of Get(MipMaps) */
+    const u8* GetIndexed(i32 MipMaps) const;
+
+    /** Palette premultiplied by lit color, cached per light level */
+    const VColorARGB* GetLitPalette(VColorARGB LitColor) const;
+
 private:
     void GenerateMipMaps(i32 MaxMipMaps);
+
+    /** 2x2 box filter of two source rows into one destination row */
+    static void DownsampleRow(u32* Dest, const u32* SourceRow0, const u32* SourceRow1, i32 DestWidth);
+
+    /** Takes indices of base level from source image and requantizes the rest of mip chain to palette */
+    void GenerateIndexedLevels(const SDL_Surface* Source, const VColorLUT& LUT);
+
+    static b32 MakeCacheKey(const char* Path, const VVector3& ColorCorrection, i32 MaxMipMaps, VTextureCacheHeader& OutKey, char (&OutCachePath)[512]);
+    b32 LoadFromCache(const char* CachePath, const VTextureCacheHeader& Key);
+    void SaveToCache(const char* CachePath, const VTextureCacheHeader& Key) const;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include <emmintrin.h>
+#include "Common/Platform/Memory.h"
+#include "Engine/Core/JobSystem.h"
+#include "Engine/Graphics/Rendering/Upscaler.h"
+
+namespace Volition
+{
+
+static constexpr i32f MinRowsPerBatch = 16;
+
+/** Center of destination pixel in source space, 16.16 */
+static VLN_FINLINE i64 MapToSource(i32 DestCoord, i32 SourceSize, i32 DestSize)
+{
+    return (((i64)DestCoord * 2 + 1) * SourceSize * 65536) / ((i64)DestSize * 2) - 32768;
+}
+
+void VUpscaler::Upscale(VSurface& Source, const VVector2i& Viewport, VSurface& Dest, b32 bInBilinear)
+{
+    // Let SDL handle formats we don't expect
+    if (Source.SDLSurface->format->BytesPerPixel != 4 || Dest.SDLSurface->format->format != Source.SDLSurface->format->format)
+    {
+        VRelativeRectInt SourceRect = { 0, 0, Viewport.X, Viewport.Y };
+        Source.Blit(&SourceRect, &Dest, nullptr);
+        return;
+    }
+
+    u32* SourceBuffer;
+    i32 SourcePitch;
+    u32* DestBuffer;
+    i32 DestPitch;
+    Source.Lock(SourceBuffer, SourcePitch);
+    Dest.Lock(DestBuffer, DestPitch);
+
+    const i32 SourceWidth = Viewport.X;
+    const i32 SourceHeight = Viewport.Y;
+    const i32 DestWidth = Dest.GetWidth();
+    const i32 DestHeight = Dest.GetHeight();
+
+    if (SourceWidth == DestWidth && SourceHeight == DestHeight)
+    {
+        if (SourcePitch == DestPitch && SourceHeight == Source.GetHeight())
+        {
+            Memory.MemCopy(DestBuffer, SourceBuffer, DestPitch * DestHeight * sizeof(u32));
+        }
+        else
+        {
+            JobSystem.ParallelFor(DestHeight, MinRowsPerBatch, [&](i32 Begin, i32 End)
+            {
+                CopyRows(SourceBuffer, SourcePitch, DestBuffer, DestPitch, DestWidth, Begin, End);
+            });
+        }
+    }
+    else
+    {
+        // Bilinear needs two texels in a row
+        bInBilinear = bInBilinear && SourceWidth > 1;
+        UpdateColumns(SourceWidth, DestWidth, bInBilinear);
+
+        JobSystem.ParallelFor(DestHeight, MinRowsPerBatch, [&](i32 Begin, i32 End)
+        {
+            if (bBilinear)
+            {
+                BilinearRows(SourceBuffer, SourcePitch, SourceHeight, DestBuffer, DestPitch, DestHeight, Begin, End);
+            }
+            else
+            {
+                NearestRows(SourceBuffer, SourcePitch, SourceHeight, DestBuffer, DestPitch, DestHeight, Begin, End);
+            }
+        });
+    }
+
+    Dest.Unlock();
+    Source.Unlock();
+}
+
+void VUpscaler::UpdateColumns(i32 InSourceWidth, i32 InDestWidth, b32 bInBilinear)
+{
+    if (InSourceWidth == SourceWidth && InDestWidth == DestWidth && bInBilinear == bBilinear)
+    {
+        return;
+    }
+
+    SourceWidth = InSourceWidth;
+    DestWidth = InDestWidth;
+    bBilinear = bInBilinear;
+
+    SourceX.Resize(DestWidth);
+    WeightX.Resize(DestWidth);
+
+    for (i32f X = 0; X < DestWidth; ++X)
+    {
+        if (bBilinear)
+        {
+            i64 Fixed = MapToSource(X, SourceWidth, DestWidth);
+            Fixed = VLN_MAX(Fixed, 0);
+
+            i32 Texel = (i32)(Fixed >> 16);
+            i32 Weight = (i32)((Fixed >> 8) & 0xFF);
+
+            // Keep right texel inside the row
+            if (Texel >= SourceWidth - 1)
+            {
+                Texel = SourceWidth - 2;
+                Weight = 256;
+            }
+
+            SourceX[X] = Texel;
+            WeightX[X] = Weight;
+        }
+        else
+        {
+            SourceX[X] = (i32)((i64)X * SourceWidth / DestWidth);
+            WeightX[X] = 0;
+        }
+    }
+}
+
+void VUpscaler::CopyRows(const u32* Source, i32 SourcePitch, u32* Dest, i32 DestPitch, i32 Width, i32 YBegin, i32 YEnd)
+{
+    for (i32f Y = YBegin; Y < YEnd; ++Y)
+    {
+        Memory.MemCopy(Dest + Y * DestPitch, Source + Y * SourcePitch, Width * sizeof(u32));
+    }
+}
+
+void VUpscaler::NearestRows(const u32* Source, i32 SourcePitch, i32 SourceHeight, u32* Dest, i32 DestPitch, i32 DestHeight, i32 YBegin, i32 YEnd) const
+{
+    const i32* MapX = SourceX.GetData();
+
+    i32 Ratio = 0;
+    if (DestWidth == SourceWidth * 2)
+    {
+        Ratio = 2;
+    }
+    else if (DestWidth == SourceWidth * 4)
+    {
+        Ratio = 4;
+    }
+
+    i32 PrevSourceY = -1;
+
+    for (i32f Y = YBegin; Y < YEnd; ++Y)
+    {
+        const i32 SourceY = (i32)((i64)Y * SourceHeight / DestHeight);
+        u32* DestRow = Dest + Y * DestPitch;
+
+        // Same source row, copy what we've just produced
+        if (SourceY == PrevSourceY)
+        {
+            Memory.MemCopy(DestRow, DestRow - DestPitch, DestWidth * sizeof(u32));
+            continue;
+        }
+        PrevSourceY = SourceY;
+
+        const u32* SourceRow = Source + SourceY * SourcePitch;
+
+        if (Ratio == 2)
+        {
+            Double(DestRow, SourceRow, SourceWidth);
+        }
+        else if (Ratio == 4)
+        {
+            Quadruple(DestRow, SourceRow, SourceWidth);
+        }
+        else
+        {
+            for (i32f X = 0; X < DestWidth; ++X)
+            {
+                DestRow[X] = SourceRow[MapX[X]];
+            }
+        }
+    }
+}
+
+void VUpscaler::BilinearRows(const u32* Source, i32 SourcePitch, i32 SourceHeight, u32* Dest, i32 DestPitch, i32 DestHeight, i32 YBegin, i32 YEnd) const
+{
+    const i32* MapX = SourceX.GetData();
+    const i32* MapWeightX = WeightX.GetData();
+
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i Max = _mm_set1_epi16(256);
+
+    for (i32f Y = YBegin; Y < YEnd; ++Y)
+    {
+        i64 Fixed = MapToSource(Y, SourceHeight, DestHeight);
+        Fixed = VLN_MAX(Fixed, 0);
+
+        const i32 SourceY0 = VLN_MIN((i32)(Fixed >> 16), SourceHeight - 1);
+        const i32 SourceY1 = VLN_MIN(SourceY0 + 1, SourceHeight - 1);
+
+        const u32* SourceRow0 = Source + SourceY0 * SourcePitch;
+        const u32* SourceRow1 = Source + SourceY1 * SourcePitch;
+        u32* DestRow = Dest + Y * DestPitch;
+
+        const __m128i WeightY1 = _mm_set1_epi16((i16)((Fixed >> 8) & 0xFF));
+        const __m128i WeightY0 = _mm_sub_epi16(Max, WeightY1);
+
+        for (i32f X = 0; X < DestWidth; ++X)
+        {
+            // Left and right texels of both rows, 16 bits per channel
+            const __m128i Top    = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(SourceRow0 + MapX[X])), Zero);
+            const __m128i Bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(SourceRow1 + MapX[X])), Zero);
+
+            // Vertical lerp, each product fits in 16 bits since weights sum to 256
+            __m128i Column = _mm_add_epi16(_mm_mullo_epi16(Top, WeightY0), _mm_mullo_epi16(Bottom, WeightY1));
+            Column = _mm_srli_epi16(Column, 8);
+
+            // Horizontal lerp, left texel in low half, right in high half
+            const __m128i WeightRight = _mm_set1_epi16((i16)MapWeightX[X]);
+            const __m128i Weights = _mm_unpacklo_epi64(_mm_sub_epi16(Max, WeightRight), WeightRight);
+
+            __m128i Result = _mm_mullo_epi16(Column, Weights);
+            Result = _mm_add_epi16(Result, _mm_srli_si128(Result, 8));
+            Result = _mm_srli_epi16(Result, 8);
+
+            DestRow[X] = (u32)_mm_cvtsi128_si32(_mm_packus_epi16(Result, Result));
+        }
+    }
+}
+
+void VUpscaler::Double(u32* Dest, const u32* Source, i32 Width)
+{
+    i32f X = 0;
+
+    for ( ; X + 4 <= Width; X += 4)
+    {
+        const __m128i Pixels = _mm_loadu_si128((const __m128i*)(Source + X));
+
+        _mm_storeu_si128((__m128i*)(Dest + X * 2),     _mm_unpacklo_epi32(Pixels, Pixels));
+        _mm_storeu_si128((__m128i*)(Dest + X * 2 + 4), _mm_unpackhi_epi32(Pixels, Pixels));
+    }
+
+    for ( ; X < Width; ++X)
+    {
+        Dest[X * 2] = Dest[X * 2 + 1] = Source[X];
+    }
+}
+
+void VUpscaler::Quadruple(u32* Dest, const u32* Source, i32 Width)
+{
+    i32f X = 0;
+
+    for ( ; X + 4 <= Width; X += 4)
+    {
+        const __m128i Pixels = _mm_loadu_si128((const __m128i*)(Source + X));
+
+        _mm_storeu_si128((__m128i*)(Dest + X * 4),      _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(0, 0, 0, 0)));
+        _mm_storeu_si128((__m128i*)(Dest + X * 4 + 4),  _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(1, 1, 1, 1)));
+        _mm_storeu_si128((__m128i*)(Dest + X * 4 + 8),  _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(2, 2, 2, 2)));
+        _mm_storeu_si128((__m128i*)(Dest + X * 4 + 12), _mm_shuffle_epi32(Pixels, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+
+    for ( ; X < Width; ++X)
+    {
+        Dest[X * 4] = Dest[X * 4 + 1] = Dest[X * 4 + 2] = Dest[X * 4 + 3] = Source[X];
+    }
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Platform/Platform.h"
+#include "Engine/Graphics/Rendering/Surface.h"
+
+namespace Volition
+{
+
+/** Copies viewport of render target to window surface, scaling if sizes differ. Rows are split between job threads */
+class VUpscaler
+{
+    /** Per destination column, rebuilt when sizes change */
+    TArray<i32> SourceX;
+    TArray<i32> WeightX; /** [0, 256] for right texel in bilinear mode */
+
+    i32 SourceWidth = 0;
+    i32 DestWidth = 0;
+    b32 bBilinear = false;
+
+public:
+    /** Viewport is top left part of Source with given size */
+    void Upscale(VSurface& Source, const VVector2i& Viewport, VSurface& Dest, b32 bInBilinear);
+
+private:
+    void UpdateColumns(i32 InSourceWidth, i32 InDestWidth, b32 bInBilinear);
+
+    static void CopyRows(const u32* Source, i32 SourcePitch, u32* Dest, i32 DestPitch, i32 Width, i32 YBegin, i32 YEnd);
+    void NearestRows(const u32* Source, i32 SourcePitch, i32 SourceHeight, u32* Dest, i32 DestPitch, i32 DestHeight, i32 YBegin, i32 YEnd) const;
+    void BilinearRows(const u32* Source, i32 SourcePitch, i32 SourceHeight, u32* Dest, i32 DestPitch, i32 DestHeight, i32 YBegin, i32 YEnd) const;
+
+    /** Integer ratio nearest for one row, Dest gets Width * Ratio pixels */
+    static void Double(u32* Dest, const u32* Source, i32 Width);
+    static void Quadruple(u32* Dest, const u32* Source, i32 Width);
+};
+
+}
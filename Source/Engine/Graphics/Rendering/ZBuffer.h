@@ -9,12 +9,20 @@ namespace Volition
 
 class VZBuffer
 {
+public:
+    /** Every frame writes 1/z + Bias, so values of previous frames are always behind and we don't clear */
+    static constexpr fx28 EpochRange = (1 << Fx28Shift) + (1 << (Fx28Shift - 4)); /** A bit more than max of 1/z */
+    static constexpr i32f NumEpochs = 7; /** Max biased value must fit in positive fx28 */
+
 public:
     u32* Buffer;
     i32 Pitch;
     i32 Width;
     i32 Height;
 
+    fx28 Bias = 0;
+    i32 Epoch = 0;
+
     b32 bInitialized = false;
 
 private:
@@ -30,6 +38,7 @@ public:
         Width = InWidth;
         Height = InHeight;
 
+        Clear();
         bInitialized = true;
     }
 
@@ -47,6 +56,23 @@ public:
     VLN_FINLINE void Clear()
     {
         Memory.MemSetQuad(Buffer, 0, Pitch * Height);
+
+        Epoch = 0;
+        Bias = 0;
+    }
+
+    /** Real clear happens only when epochs wrap around */
+    VLN_FINLINE void NextFrame()
+    {
+        if (Epoch + 1 >= NumEpochs)
+        {
+            Clear();
+        }
+        else
+        {
+            ++Epoch;
+            Bias = Epoch * EpochRange;
+        }
     }
 };
 
@@ -20,6 +20,8 @@ namespace EMaterialAttr
         ShadeModeFlat     = VLN_BIT(5),
         ShadeModeGouraud  = VLN_BIT(6),
         ShadeModeTexture  = VLN_BIT(7),
+
+        Shadow = VLN_BIT(8), /** Only marks shadow mask, see VShadowMask */
     };
 }
 
@@ -1,5 +1,6 @@
 #include <cstdio>
 #include <cerrno>
+#include <algorithm>
 #include "Common/Types/Common.h"
 #include "Common/Types/Array.h"
 #include "Common/Platform/Memory.h"
@@ -7,6 +8,7 @@
 #include "Engine/World/World.h"
 #include "Engine/Graphics/Rendering/Renderer.h"
 #include "Engine/Graphics/Scene/Mesh.h"
+#include "Engine/Graphics/Scene/PoseCache.h"
 
 namespace Volition
 {
@@ -44,6 +46,8 @@ void VMesh::Allocate(i32 InNumVtx, i32 InNumPoly, i32 InNumFrames, i32 InNumText
     TotalNumVtx = InNumVtx * InNumFrames;
     NumPoly     = InNumPoly;
     NumFrames   = InNumFrames;
+
+    MarkWorldVtxDirty();
 }
 
 void VMesh::Destroy()
@@ -54,6 +58,45 @@ void VMesh::Destroy()
     VLN_SAFE_DELETE_ARRAY(TextureCoordsList);
     VLN_SAFE_DELETE_ARRAY(AverageRadiusList);
     VLN_SAFE_DELETE_ARRAY(MaxRadiusList);
+    VLN_SAFE_DELETE_ARRAY(ClusterList);
+    NumClusters = 0;
+
+    SetShadowMesh(nullptr);
+    if (ShadowMeshOwner)
+    {
+        ShadowMeshOwner->ShadowMesh = nullptr;
+        ShadowMeshOwner = nullptr;
+    }
+}
+
+VLN_DEFINE_LOG_CHANNEL(hLogMesh, "Mesh");
+
+b32 VMesh::SetShadowMesh(VMesh* InShadowMesh)
+{
+    if (InShadowMesh == ShadowMesh)
+    {
+        return true;
+    }
+
+    if (InShadowMesh)
+    {
+        // Proxy is transformed in place for its owner every frame, so two owners would race on it
+        if (InShadowMesh == this || InShadowMesh->ShadowMeshOwner || InShadowMesh->ShadowMesh || ShadowMeshOwner)
+        {
+            VLN_ERROR(hLogMesh, "Shadow mesh is already used by another mesh or can't be a proxy, each mesh needs its own copy\n");
+            return false;
+        }
+
+        InShadowMesh->ShadowMeshOwner = this;
+    }
+
+    if (ShadowMesh)
+    {
+        ShadowMesh->ShadowMeshOwner = nullptr;
+    }
+
+    ShadowMesh = InShadowMesh;
+    return true;
 }
 
 void VMesh::ResetRenderState()
@@ -175,36 +218,328 @@ void VMesh::ComputeVertexNormals()
     }
 }
 
-void VMesh::TransformModelToWorld(ETransformType Type)
+void VMesh::ComputeClusters()
 {
-    VMatrix44 MatNormalTransform;
-    MatNormalTransform.BuildRotationXYZ(Rotation.X, Rotation.Y, Rotation.Z); // Rotation
+    VLN_SAFE_DELETE_ARRAY(ClusterList);
+    NumClusters = 0;
+
+    if (NumPoly <= 0)
+    {
+        return;
+    }
+
+    // Unnormalized normal of polygon in frame
+    const auto GetPolyNormal = [this](const VPoly& Poly, i32f FrameIndex) -> VVector4
+    {
+        const VVertex* Frame = &HeadLocalVtxList[FrameIndex * NumVtx];
+        const VVector4& P0 = Frame[Poly.VtxIndices[0]].Position;
+
+        VVector4 Normal;
+        VVector4::Cross(Frame[Poly.VtxIndices[1]].Position - P0, Frame[Poly.VtxIndices[2]].Position - P0, Normal);
+        return Normal;
+    };
+
+    /**
+        Normal of polygon interpolated between frame and next one is (1-t)^2 * N1 + 2t(1-t) * NMid + t^2 * N2,
+        where NMid mixes edges of both frames. It's never outside of convex cone around N1, NMid and N2
+    */
+    const auto GetPolyMidNormal = [this](const VPoly& Poly, i32f FrameIndex) -> VVector4
+    {
+        const VVertex* Frame1 = &HeadLocalVtxList[FrameIndex * NumVtx];
+        const VVertex* Frame2 = Frame1 + NumVtx;
+
+        const VVector4 Edge11 = Frame1[Poly.VtxIndices[1]].Position - Frame1[Poly.VtxIndices[0]].Position;
+        const VVector4 Edge12 = Frame1[Poly.VtxIndices[2]].Position - Frame1[Poly.VtxIndices[0]].Position;
+        const VVector4 Edge21 = Frame2[Poly.VtxIndices[1]].Position - Frame2[Poly.VtxIndices[0]].Position;
+        const VVector4 Edge22 = Frame2[Poly.VtxIndices[2]].Position - Frame2[Poly.VtxIndices[0]].Position;
+
+        VVector4 Cross1, Cross2;
+        VVector4::Cross(Edge11, Edge22, Cross1);
+        VVector4::Cross(Edge21, Edge12, Cross2);
+        return Cross1 + Cross2;
+    };
+
+    // Sort polygons by dominant axis of normal, then by morton code of center in bounding box
+    VVector4 Min = HeadLocalVtxList[0].Position;
+    VVector4 Max = Min;
+
+    for (i32f VtxIndex = 1; VtxIndex < NumVtx; ++VtxIndex)
+    {
+        const VVector4& Pos = HeadLocalVtxList[VtxIndex].Position;
+
+        for (i32f i = 0; i < 3; ++i)
+        {
+            Min.C[i] = VLN_MIN(Min.C[i], Pos.C[i]);
+            Max.C[i] = VLN_MAX(Max.C[i], Pos.C[i]);
+        }
+    }
+
+    const auto SpreadBits = [](u32 Value) -> u32
+    {
+        Value = (Value | (Value << 16)) & 0x030000FF;
+        Value = (Value | (Value << 8))  & 0x0300F00F;
+        Value = (Value | (Value << 4))  & 0x030C30C3;
+        Value = (Value | (Value << 2))  & 0x09249249;
+        return Value;
+    };
+
+    TArray<u32> Keys(NumPoly);
+    TArray<i32> Order(NumPoly);
+
+    for (i32f PolyIndex = 0; PolyIndex < NumPoly; ++PolyIndex)
+    {
+        const VPoly& Poly = PolyList[PolyIndex];
+        const VVector4 Normal = GetPolyNormal(Poly, 0);
+
+        i32f Axis = 0;
+        for (i32f i = 1; i < 3; ++i)
+        {
+            if (Math.Abs(Normal.C[i]) > Math.Abs(Normal.C[Axis]))
+            {
+                Axis = i;
+            }
+        }
+        const u32 Bin = (u32)(Axis * 2 + (Normal.C[Axis] < 0.0f ? 1 : 0));
+
+        u32 Morton = 0;
+        for (i32f i = 0; i < 3; ++i)
+        {
+            const f32 Center = (
+                HeadLocalVtxList[Poly.VtxIndices[0]].Position.C[i] +
+                HeadLocalVtxList[Poly.VtxIndices[1]].Position.C[i] +
+                HeadLocalVtxList[Poly.VtxIndices[2]].Position.C[i]
+            ) / 3.0f;
+            const f32 Size = Max.C[i] - Min.C[i];
+            const u32 Cell = Size > 0.0f ? (u32)VLN_MIN((Center - Min.C[i]) / Size * 1023.0f, 1023.0f) : 0;
+
+            Morton |= SpreadBits(Cell) << i;
+        }
+
+        Keys[PolyIndex] = (Bin << 29) | (Morton >> 1);
+        Order[PolyIndex] = (i32)PolyIndex;
+    }
+
+    std::sort(Order.GetData(), Order.GetData() + NumPoly, [&Keys](i32 A, i32 B)
+    {
+        return Keys[A] < Keys[B];
+    });
+
+    {
+        TArray<VPoly> SortedPolyList(NumPoly);
+        for (i32f PolyIndex = 0; PolyIndex < NumPoly; ++PolyIndex)
+        {
+            SortedPolyList[PolyIndex] = PolyList[Order[PolyIndex]];
+        }
+        Memory.MemCopy(PolyList, SortedPolyList.GetData(), sizeof(VPoly) * NumPoly);
+    }
+
+    // Split sorted polygons, cluster never mixes normal directions
+    TArray<VPolyCluster> Clusters;
+
+    for (i32f PolyIndex = 0; PolyIndex < NumPoly;)
+    {
+        const u32 Bin = Keys[Order[PolyIndex]] >> 29;
+
+        VPolyCluster& Cluster = Clusters.EmplaceBack();
+        Cluster.FirstPoly = (i32)PolyIndex;
+        Cluster.NumPoly = 0;
+
+        while (PolyIndex < NumPoly && Cluster.NumPoly < MaxPolyPerCluster && (Keys[Order[PolyIndex]] >> 29) == Bin)
+        {
+            ++Cluster.NumPoly;
+            ++PolyIndex;
+        }
+    }
+
+    // Bounds and normal cones over all frames, cones also bound every interpolated pose between neighbour frames
+    for (auto& Cluster : Clusters)
+    {
+        VVector4 ClusterMin = HeadLocalVtxList[PolyList[Cluster.FirstPoly].VtxIndices[0]].Position;
+        VVector4 ClusterMax = ClusterMin;
+        VVector4 AxisSum = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+        for (i32f PolyIndex = Cluster.FirstPoly; PolyIndex < Cluster.FirstPoly + Cluster.NumPoly; ++PolyIndex)
+        {
+            const VPoly& Poly = PolyList[PolyIndex];
+
+            for (i32f FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+            {
+                for (i32f i = 0; i < 3; ++i)
+                {
+                    const VVector4& Pos = HeadLocalVtxList[FrameIndex * NumVtx + Poly.VtxIndices[i]].Position;
+
+                    for (i32f Component = 0; Component < 3; ++Component)
+                    {
+                        ClusterMin.C[Component] = VLN_MIN(ClusterMin.C[Component], Pos.C[Component]);
+                        ClusterMax.C[Component] = VLN_MAX(ClusterMax.C[Component], Pos.C[Component]);
+                    }
+                }
+
+                VVector4 Normal = GetPolyNormal(Poly, FrameIndex);
+                if (Normal.GetLength() > Math.Epsilon5)
+                {
+                    Normal.Normalize();
+                    AxisSum += Normal;
+                }
+            }
+        }
+
+        Cluster.Center = {
+            (ClusterMin.X + ClusterMax.X) * 0.5f,
+            (ClusterMin.Y + ClusterMax.Y) * 0.5f,
+            (ClusterMin.Z + ClusterMax.Z) * 0.5f,
+            1.0f
+        };
+        Cluster.Radius = 0.0f;
+
+        for (i32f PolyIndex = Cluster.FirstPoly; PolyIndex < Cluster.FirstPoly + Cluster.NumPoly; ++PolyIndex)
+        {
+            for (i32f FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+            {
+                for (i32f i = 0; i < 3; ++i)
+                {
+                    const VVector4 Offset = HeadLocalVtxList[FrameIndex * NumVtx + PolyList[PolyIndex].VtxIndices[i]].Position - Cluster.Center;
+                    Cluster.Radius = VLN_MAX(Cluster.Radius, Offset.GetLength());
+                }
+            }
+        }
+
+        // Cone which can't be trusted covers everything
+        if (AxisSum.GetLength() <= Math.Epsilon5)
+        {
+            Cluster.Axis = { 0.0f, 1.0f, 0.0f, 0.0f };
+            Cluster.Angle = Math.Pi;
+            continue;
+        }
+
+        Cluster.Axis = AxisSum;
+        Cluster.Axis.Normalize();
+        Cluster.Axis.W = 0.0f;
 
-    VMatrix44 MatPositionTransform;
-    MatPositionTransform = MatNormalTransform;
-    MatPositionTransform.RowV[3] = Position; // Translation
+        f32 MinDot = 1.0f;
+
+        const auto AddToCone = [&MinDot, &Cluster](VVector4 Normal)
+        {
+            if (Normal.GetLength() > Math.Epsilon5)
+            {
+                Normal.Normalize();
+                MinDot = VLN_MIN(MinDot, VVector4::Dot(Normal, Cluster.Axis));
+            }
+        };
+
+        for (i32f PolyIndex = Cluster.FirstPoly; PolyIndex < Cluster.FirstPoly + Cluster.NumPoly; ++PolyIndex)
+        {
+            const VPoly& Poly = PolyList[PolyIndex];
+
+            for (i32f FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+            {
+                AddToCone(GetPolyNormal(Poly, FrameIndex));
+
+                if (FrameIndex < NumFrames - 1)
+                {
+                    AddToCone(GetPolyMidNormal(Poly, FrameIndex));
+                }
+            }
+        }
+
+        Cluster.Angle = std::acos(VLN_MAX(MinDot, -1.0f));
+
+        // Cone wider than half sphere isn't convex, so it doesn't bound interpolated normals anymore
+        if (NumFrames > 1 && MinDot < 0.0f)
+        {
+            Cluster.Angle = Math.Pi;
+        }
+    }
+
+    NumClusters = (i32)Clusters.GetLength();
+    ClusterList = new VPolyCluster[NumClusters];
+    Memory.MemCopy(ClusterList, Clusters.GetData(), sizeof(VPolyCluster) * NumClusters);
+
+    VLN_LOG_VERBOSE("Polygon clusters: %d\n", NumClusters);
+}
+
+b32 VMesh::UpdateWorldMatrices()
+{
+    const b32 bRotationChanged = !bWorldMatricesValid ||
+        Rotation.X != CachedRotation.X || Rotation.Y != CachedRotation.Y || Rotation.Z != CachedRotation.Z;
+    const b32 bPositionChanged = !bWorldMatricesValid ||
+        Position.X != CachedPosition.X || Position.Y != CachedPosition.Y || Position.Z != CachedPosition.Z || Position.W != CachedPosition.W;
+
+    if (!bRotationChanged && !bPositionChanged)
+    {
+        return false;
+    }
+
+    if (bRotationChanged)
+    {
+        MatWorldRotationOnly.BuildRotationXYZ(Rotation.X, Rotation.Y, Rotation.Z);
+        CachedRotation = Rotation;
+    }
+
+    MatWorld = MatWorldRotationOnly;
+    MatWorld.RowV[3] = Position; // Translation
+    CachedPosition = Position;
+
+    bWorldMatricesValid = true;
+    return true;
+}
+
+void VMesh::ComputeVtxDataHash()
+{
+    // FNV-1a of positions and normals of all frames
+    u64 Hash = 14695981039346656037ull;
+
+    for (i32f VtxIndex = 0; VtxIndex < TotalNumVtx; ++VtxIndex)
+    {
+        const VVertex& Vtx = HeadLocalVtxList[VtxIndex];
+        const f32 Values[6] = { Vtx.Position.X, Vtx.Position.Y, Vtx.Position.Z, Vtx.Normal.X, Vtx.Normal.Y, Vtx.Normal.Z };
+
+        const u8* Bytes = (const u8*)Values;
+        for (VSizeType i = 0; i < sizeof(Values); ++i)
+        {
+            Hash = (Hash ^ Bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    VtxDataHash = Hash;
+}
+
+void VMesh::TransformModelToWorld(ETransformType Type)
+{
+    const b32 bMoved = UpdateWorldMatrices();
 
     if (Type == ETransformType::LocalToTrans)
     {
+        // Static mesh keeps its world vertices until it moves
+        if (!bMoved && State & EMeshState::WorldVtxCached)
+        {
+            return;
+        }
+
         for (i32f i = 0; i < NumVtx; ++i)
         {
             // Copy vertex data
             TransVtxList[i] = LocalVtxList[i];
 
-            VMatrix44::MulVecMat(LocalVtxList[i].Normal, MatNormalTransform, TransVtxList[i].Normal);
-            VMatrix44::MulVecMat(LocalVtxList[i].Position, MatPositionTransform, TransVtxList[i].Position);
+            VMatrix44::MulVecMat(LocalVtxList[i].Normal, MatWorldRotationOnly, TransVtxList[i].Normal);
+            VMatrix44::MulVecMat(LocalVtxList[i].Position, MatWorld, TransVtxList[i].Position);
         }
+
+        CachedFrame = 0;
+        State |= EMeshState::WorldVtxCached;
     }
     else // TransOnly
     {
         for (i32f i = 0; i < NumVtx; ++i)
         {
-            VMatrix44::MulVecMat(LocalVtxList[i].Normal, MatNormalTransform, TransVtxList[i].Normal);
+            VMatrix44::MulVecMat(LocalVtxList[i].Normal, MatWorldRotationOnly, TransVtxList[i].Normal);
 
             VVector4 Result;
-            VMatrix44::MulVecMat(TransVtxList[i].Position, MatPositionTransform, Result);
+            VMatrix44::MulVecMat(TransVtxList[i].Position, MatWorld, Result);
             TransVtxList[i].Position = Result;
         }
+
+        MarkWorldVtxDirty();
     }
 }
 
@@ -212,6 +547,8 @@ void VMesh::Transform(const VMatrix44& M, ETransformType Type)
 {
     VVector4 Res;
 
+    MarkWorldVtxDirty();
+
     switch (Type)
     {
     case ETransformType::LocalOnly:
@@ -812,6 +1149,8 @@ b32 VMesh::LoadCOB(const char* Path, const VVector4& InPosition, const VVector4&
         ComputeRadius();
         ComputePolygonNormalsLength();
         ComputeVertexNormals();
+        ComputeClusters();
+        ComputeVtxDataHash();
     }
 
     VLN_NOTE(hLogCOB, "Object parsing ended\n");
@@ -910,6 +1249,8 @@ void VMesh::GenerateTerrain(const char* HeightMap, const char* Texture, f32 Size
     ComputeRadius();
     ComputePolygonNormalsLength();
     ComputeVertexNormals();
+    ComputeClusters();
+    ComputeVtxDataHash();
 
     Position = { -Size / 2.0f, -Height / 2.0f, -Size / 2.0f };
 
@@ -1039,14 +1380,13 @@ void VMesh::PlayAnimation(EMD2AnimationId AnimationId, b32 bLoop, EAnimationInte
     CurrentFrame = (f32)MD2AnimationTable[(i32f)AnimationId].FrameStart;
 }
 
-void VMesh::UpdateAnimationAndTransformModelToWorld(f32 DeltaTime)
+void VMesh::UpdateAnimationAndTransformModelToWorld(f32 DeltaTime, VPoseCache* PoseCache)
 {
-    VMatrix44 MatNormalTransform;
-    MatNormalTransform.BuildRotationXYZ(Rotation.X, Rotation.Y, Rotation.Z); // Rotation
+    UpdateWorldMatrices();
+    MarkWorldVtxDirty();
 
-    VMatrix44 MatPositionTransform;
-    MatPositionTransform = MatNormalTransform;
-    MatPositionTransform.RowV[3] = Position; // Translation
+    const VMatrix44& MatNormalTransform = MatWorldRotationOnly;
+    const VMatrix44& MatPositionTransform = MatWorld;
 
     i32f Frame1 = (i32f)CurrentFrame;
     i32f Frame2;
@@ -1062,7 +1402,23 @@ void VMesh::UpdateAnimationAndTransformModelToWorld(f32 DeltaTime)
         Frame2 = Frame1;
     }
 
-    if (Frame2 < NumFrames) // Interpolate if we didn't overflow
+    if (Frame2 < NumFrames && PoseCache) // Interpolated positions are shared between instances
+    {
+        const VVector4* PosePositions = PoseCache->GetPose(*this, (i32)Frame1, (i32)Frame2, CurrentFrame - Math.Floor(CurrentFrame));
+
+        for (i32f VtxIndex = 0; VtxIndex < NumVtx; ++VtxIndex)
+        {
+            i32f Frame1VtxIndex = (Frame1 * NumVtx) + VtxIndex;
+
+            // Copy vertex data
+            TransVtxList[VtxIndex] = HeadLocalVtxList[Frame1VtxIndex];
+
+            // Transform position and normal
+            VMatrix44::MulVecMat(PosePositions[VtxIndex], MatPositionTransform, TransVtxList[VtxIndex].Position);
+            VMatrix44::MulVecMat(HeadLocalVtxList[Frame1VtxIndex].Normal, MatNormalTransform, TransVtxList[VtxIndex].Normal);
+        }
+    }
+    else if (Frame2 < NumFrames) // Interpolate if we didn't overflow
     {
         f32 FrameInterp = CurrentFrame - Math.Floor(CurrentFrame);
 
@@ -1096,6 +1452,66 @@ void VMesh::UpdateAnimationAndTransformModelToWorld(f32 DeltaTime)
         }
     }
 
+    UpdateAnimation(DeltaTime);
+}
+
+void VMesh::UpdateReducedAnimationAndTransformModelToWorld(f32 DeltaTime, b32 bUpdateFrame)
+{
+    b32 bMoved = UpdateWorldMatrices();
+
+    // Fixed frame without interpolation, its local pose is already in HeadLocalVtxList and kept between ticks
+    if (bUpdateFrame || ~State & EMeshState::WorldVtxCached)
+    {
+        const i32 Frame = VLN_MIN((i32)CurrentFrame, NumFrames - 1);
+
+        if (~State & EMeshState::WorldVtxCached || Frame != CachedFrame)
+        {
+            Memory.MemCopy(TransVtxList, &HeadLocalVtxList[Frame * NumVtx], sizeof(VVertex) * NumVtx);
+
+            CachedFrame = Frame;
+            bMoved = true;
+        }
+    }
+
+    // Frames in between only reapply world matrix to positions and normals, and only if mesh moved
+    if (bMoved)
+    {
+        const VVertex* FrameVtxList = &HeadLocalVtxList[CachedFrame * NumVtx];
+
+        for (i32f VtxIndex = 0; VtxIndex < NumVtx; ++VtxIndex)
+        {
+            VMatrix44::MulVecMat(FrameVtxList[VtxIndex].Position, MatWorld, TransVtxList[VtxIndex].Position);
+            VMatrix44::MulVecMat(FrameVtxList[VtxIndex].Normal, MatWorldRotationOnly, TransVtxList[VtxIndex].Normal);
+        }
+    }
+
+    State |= EMeshState::WorldVtxCached;
+    UpdateAnimation(DeltaTime);
+}
+
+void VMesh::TransformFrameModelToWorld(i32 Frame)
+{
+    const b32 bMoved = UpdateWorldMatrices();
+
+    if (bMoved || ~State & EMeshState::WorldVtxCached || Frame != CachedFrame)
+    {
+        const VVertex* FrameVtxList = &HeadLocalVtxList[Frame * NumVtx];
+
+        for (i32f VtxIndex = 0; VtxIndex < NumVtx; ++VtxIndex)
+        {
+            TransVtxList[VtxIndex] = FrameVtxList[VtxIndex]; // Copy vertex data
+
+            VMatrix44::MulVecMat(FrameVtxList[VtxIndex].Position, MatWorld, TransVtxList[VtxIndex].Position);
+            VMatrix44::MulVecMat(FrameVtxList[VtxIndex].Normal, MatWorldRotationOnly, TransVtxList[VtxIndex].Normal);
+        }
+
+        CachedFrame = Frame;
+        State |= EMeshState::WorldVtxCached;
+    }
+}
+
+void VMesh::UpdateAnimation(f32 DeltaTime)
+{
     // Check if we already played animation
     if (State & EMeshState::AnimationPlayed)
     {
@@ -1314,6 +1730,8 @@ b32 VMesh::LoadMD2(const char* Path, const char* InSkinPath, i32 SkinIndex, VVec
     ComputeRadius();
     ComputePolygonNormalsLength();
     ComputeVertexNormals();
+    ComputeClusters();
+    ComputeVtxDataHash();
 
     VLN_NOTE(hLogMD2, "Parsing ended\n");
     return true;
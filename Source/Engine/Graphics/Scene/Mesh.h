@@ -8,6 +8,8 @@
 namespace Volition
 {
 
+class VPoseCache;
+
 namespace EMeshState
 {
     enum Type
@@ -15,7 +17,8 @@ namespace EMeshState
         Active          = VLN_BIT(1),
         Visible         = VLN_BIT(2),
         Culled          = VLN_BIT(3),
-        AnimationPlayed = VLN_BIT(4)
+        AnimationPlayed = VLN_BIT(4),
+        WorldVtxCached  = VLN_BIT(5)  /** TransVtxList is CachedFrame in world space for CachedPosition and CachedRotation */
     };
 }
 
@@ -105,6 +108,7 @@ VLN_DECL_ALIGN_SSE() class VMesh
 {
 public:
     static constexpr i32f MaxMaterialsPerModel = 256;
+    static constexpr i32f MaxPolyPerCluster = 64;
 
 public:
     char Name[64];
@@ -115,6 +119,15 @@ public:
     VPoint4 Position;
     VVector3 Rotation;
 
+    /** Position and rotation of MatWorld, compared every frame to find out if mesh moved */
+    VPoint4 CachedPosition;
+    VVector3 CachedRotation;
+    i32 CachedFrame;
+    b32 bWorldMatricesValid;
+
+    VMatrix44 MatWorld;
+    VMatrix44 MatWorldRotationOnly;
+
     i32 NumFrames;
     f32 CurrentFrame;
 
@@ -130,15 +143,27 @@ public:
     VVertex* HeadLocalVtxList;
     VVertex* HeadTransVtxList;
 
+    u64 VtxDataHash; /** Equal for meshes with the same frames, i.e. same model with different skins */
+
     i32 NumPoly;
     VPoly* PolyList;
 
+    i32 NumClusters;
+    VPolyCluster* ClusterList;
+
     f32* AverageRadiusList;
     f32* MaxRadiusList;
 
     i32 NumTextureCoords;
     VPoint2* TextureCoordsList;
 
+    /**
+        Lower detail mesh projected as shadow instead of this one, not owned, set with SetShadowMesh().
+        Follows position, rotation and frame of this mesh, so it can't be shared between meshes
+    */
+    VMesh* ShadowMesh;
+    VMesh* ShadowMeshOwner; /** Mesh which uses this one as its shadow proxy */
+
 public:
     VMesh();
 
@@ -149,6 +174,12 @@ public:
     void Allocate(i32 InNumVtx, i32 InNumPoly, i32 InNumFrames, i32 InNumTextureCoords = -1);
     void Destroy();
 
+    /**
+        Gives this mesh its own shadow proxy, nullptr removes it.
+        Returns false if proxy is already used by another mesh or has a proxy itself
+    */
+    b32 SetShadowMesh(VMesh* InShadowMesh);
+
     /** Called every time before rendering */
     void ResetRenderState();
 
@@ -156,6 +187,10 @@ public:
     void ComputePolygonNormalsLength();
     void ComputeVertexNormals();
 
+    /** Reorders polygons by normal direction and position, then splits them into clusters */
+    void ComputeClusters();
+    void ComputeVtxDataHash();
+
     b32 LoadMD2(
         const char* Path,
         const char* InSkinPath = nullptr,
@@ -175,15 +210,37 @@ public:
     );
 
     void PlayAnimation(EMD2AnimationId AnimationId, b32 bLoop = false, EAnimationInterpMode InterpMode = EAnimationInterpMode::Default);
-    void UpdateAnimationAndTransformModelToWorld(f32 DeltaTime);
+    /** Interpolated positions are taken from pose cache if it's given */
+    void UpdateAnimationAndTransformModelToWorld(f32 DeltaTime, VPoseCache* PoseCache = nullptr);
+
+    /**
+        Shows fixed frame without interpolation, for animation LOD. Frame is switched only if bUpdateFrame,
+        frames in between reapply world matrix to its positions and normals only if mesh moved
+    */
+    void UpdateReducedAnimationAndTransformModelToWorld(f32 DeltaTime, b32 bUpdateFrame);
+
+    /** World vertices of one frame without interpolation, kept cached while frame and transform are the same */
+    void TransformFrameModelToWorld(i32 Frame);
 
-    /** LocalToTrans or TransOnly */
+    /** Advances animation without touching vertices, i.e. for culled meshes */
+    void UpdateAnimation(f32 DeltaTime);
+
+    /** LocalToTrans or TransOnly, LocalToTrans is skipped if mesh didn't move since last call */
     void TransformModelToWorld(ETransformType Type = ETransformType::LocalToTrans);
     void Transform(const VMatrix44& M, ETransformType Type);
     b32 Cull(const VCamera& Cam, u32 CullType = ECullType::XYZ);
 
     void GenerateTerrain(const char* HeightMap, const char* Texture, f32 Size, f32 Height, EShadeMode ShadeMode);
 
+    /** Rebuilds MatWorld and MatWorldRotationOnly if position or rotation changed, returns true if rebuilt */
+    b32 UpdateWorldMatrices();
+
+    /** Should be called after direct changes of LocalVtxList */
+    VLN_FINLINE void MarkWorldVtxDirty()
+    {
+        State &= ~EMeshState::WorldVtxCached;
+    }
+
     VLN_FINLINE f32 GetAverageRadius()
     {
         return AverageRadiusList[(i32f)CurrentFrame];
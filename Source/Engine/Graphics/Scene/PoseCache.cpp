@@ -0,0 +1,99 @@
+#include "Engine/Core/FrameArena.h"
+#include "Engine/Graphics/Scene/Mesh.h"
+#include "Engine/Graphics/Scene/PoseCache.h"
+
+namespace Volition
+{
+
+void VPoseCache::Reset()
+{
+    NumPoses = 0;
+    Poses.clear();
+
+    NumRequests.store(0);
+}
+
+const VVector4* VPoseCache::GetPose(const VMesh& Mesh, i32 Frame1, i32 Frame2, f32 Interp)
+{
+    ++NumRequests;
+
+    const i32 InterpStep = (i32)(Interp * (f32)InterpSteps + 0.5f);
+
+    // FNV-1a of pose key
+    const i32 KeyValues[4] = { Mesh.NumVtx, Frame1, Frame2, InterpStep };
+    u64 Key = 14695981039346656037ull ^ Mesh.VtxDataHash;
+    for (i32f i = 0; i < 4; ++i)
+    {
+        Key = (Key ^ (u64)(u32)KeyValues[i]) * 1099511628211ull;
+    }
+
+    // Pose is only found or reserved under lock, so threads which evaluate different poses don't wait for each other
+    VPose* Pose = nullptr;
+    b32 bEvaluate = false;
+    {
+        TScopedLock<VSpinLock> ScopedLock(Lock);
+
+        const auto It = Poses.find(Key);
+        if (It != Poses.end())
+        {
+            VPose* FoundPose = It->second;
+
+            if (FoundPose->VtxDataHash == Mesh.VtxDataHash && FoundPose->NumVtx == Mesh.NumVtx &&
+                FoundPose->Frame1 == Frame1 && FoundPose->Frame2 == Frame2 && FoundPose->InterpStep == InterpStep)
+            {
+                Pose = FoundPose;
+            }
+        }
+
+        if (!Pose)
+        {
+            Pose = new (FrameArena.AllocateArray<VPose>(1)) VPose;
+            Pose->VtxDataHash = Mesh.VtxDataHash;
+            Pose->NumVtx = Mesh.NumVtx;
+            Pose->Frame1 = Frame1;
+            Pose->Frame2 = Frame2;
+            Pose->InterpStep = InterpStep;
+            Pose->bReady.store(false, std::memory_order_relaxed);
+            Pose->Positions = FrameArena.AllocateArray<VVector4>(Mesh.NumVtx);
+
+            // On key collision pose is still evaluated but not shared
+            if (It == Poses.end())
+            {
+                Poses[Key] = Pose;
+            }
+
+            ++NumPoses;
+            bEvaluate = true;
+        }
+    }
+
+    // Another thread has reserved this pose, it's already being evaluated
+    if (!bEvaluate)
+    {
+        while (!Pose->bReady.load(std::memory_order_acquire))
+        {
+            VLN_PAUSE();
+        }
+
+        return Pose->Positions;
+    }
+
+    const f32 QuantizedInterp = (f32)InterpStep / (f32)InterpSteps;
+    const VVertex* Frame1VtxList = &Mesh.HeadLocalVtxList[Frame1 * Mesh.NumVtx];
+    const VVertex* Frame2VtxList = &Mesh.HeadLocalVtxList[Frame2 * Mesh.NumVtx];
+    VVector4* PosePositions = Pose->Positions;
+
+    for (i32f VtxIndex = 0; VtxIndex < Mesh.NumVtx; ++VtxIndex)
+    {
+        PosePositions[VtxIndex] =
+            (1.0f - QuantizedInterp) * Frame1VtxList[VtxIndex].Position +
+            QuantizedInterp          * Frame2VtxList[VtxIndex].Position;
+    }
+
+    // Publish positions to threads which wait for them
+    Pose->bReady.store(true, std::memory_order_release);
+
+    return PosePositions;
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include "Common/Types/Common.h"
+#include "Common/Types/Array.h"
+#include "Common/Types/UnorderedMap.h"
+#include "Common/Math/Vector.h"
+#include "Common/Thread/SpinLock.h"
+
+namespace Volition
+{
+
+class VMesh;
+
+/**
+    Interpolated local space positions of animated meshes, shared by instances
+    with the same vertex data, frame pair and interpolation step during one frame.
+    Can be used from many threads, lock guards only lookup and allocation, pose is evaluated outside of it
+*/
+class VPoseCache
+{
+public:
+    /** Interpolation factor is quantized to this many steps between two frames */
+    static constexpr i32f InterpSteps = 64;
+
+private:
+    struct VPose
+    {
+        u64 VtxDataHash;
+        i32 NumVtx;
+        i32 Frame1;
+        i32 Frame2;
+        i32 InterpStep;
+
+        std::atomic<b32> bReady; /** Set by thread which evaluates pose, other requesters wait for it */
+        VVector4* Positions;
+    };
+
+private:
+    /** Headers and positions are in frame arena, so they aren't moved while other threads use them */
+    TUnorderedMap<u64, VPose*> Poses;
+    i32 NumPoses = 0;
+
+    VSpinLock Lock;
+    std::atomic<i32> NumRequests;
+
+public:
+    /** Called once per frame, poses of previous frame are dropped */
+    void Reset();
+
+    /** Returns NumVtx interpolated positions between frames of mesh, valid until Reset() */
+    const VVector4* GetPose(const VMesh& Mesh, i32 Frame1, i32 Frame2, f32 Interp);
+
+    VLN_FINLINE i32 GetNumPoses() const
+    {
+        return NumPoses;
+    }
+
+    VLN_FINLINE i32 GetNumRequests() const
+    {
+        return NumRequests.load();
+    }
+};
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Common/Platform/Platform.h"
+#include "Common/Types/Common.h"
+#include "Common/Math/Vector.h"
+#include "Engine/Graphics/Types/Color.h"
+
+namespace Volition
+{
+
+/** Per-channel 256-entry lookup table for color correction */
+class VColorLUT
+{
+    u8 R[256];
+    u8 G[256];
+    u8 B[256];
+
+    VVector3 Correction;
+
+public:
+    VLN_FINLINE VColorLUT()
+    {
+        Build({ 1.0f, 1.0f, 1.0f });
+    }
+
+    VLN_FINLINE VColorLUT(const VVector3& InCorrection)
+    {
+        Build(InCorrection);
+    }
+
+    void Build(const VVector3& InCorrection)
+    {
+        Correction = InCorrection;
+
+        for (i32f i = 0; i < 256; ++i)
+        {
+            R[i] = ComputeEntry(i, Correction.X);
+            G[i] = ComputeEntry(i, Correction.Y);
+            B[i] = ComputeEntry(i, Correction.Z);
+        }
+    }
+
+    VLN_FINLINE u32 Apply(VColorARGB Pixel) const
+    {
+        return MAP_ARGB32(Pixel.A, R[Pixel.R], G[Pixel.G], B[Pixel.B]);
+    }
+
+    VLN_FINLINE void ApplyRow(u32* Row, i32 Width) const
+    {
+        for (i32f X = 0; X < Width; ++X)
+        {
+            Row[X] = Apply(Row[X]);
+        }
+    }
+
+    VLN_FINLINE const VVector3& GetCorrection() const
+    {
+        return Correction;
+    }
+
+private:
+    VLN_FINLINE static u8 ComputeEntry(i32 Value, f32 Factor)
+    {
+        // Same rounding as VSurface::CorrectColorsSlow()
+        i32 Result = (i32)( (((f32)Value / 255.0f) * Factor) * 255.0f + 0.5f );
+
+        if (Result > 255)
+        {
+            Result = 255;
+        }
+        else if (Result < 0)
+        {
+            Result = 0;
+        }
+
+        return (u8)Result;
+    }
+};
+
+}
@@ -38,6 +38,28 @@ public:
     f32 NormalLength;
 };
 
+/** Range of mesh polygons with bounding sphere and cone of their normals, all in local space */
+class VPolyCluster
+{
+public:
+    i32 FirstPoly;
+    i32 NumPoly;
+
+    VPoint4 Center;
+    f32 Radius;
+
+    VVector4 Axis;
+    f32 Angle; /** Half angle of normal cone in radians */
+};
+
+/** World space vertex of render list polygon, attributes and texture coordinates are kept only in transformed vertex */
+VLN_DECL_ALIGN_SSE() class VPolyVertex
+{
+public:
+    VVector4 Position;
+    VVector4 Normal;
+};
+
 class VPolyFace
 {
 public:
@@ -45,7 +67,7 @@ public:
 
     const VMaterial* Material;
 
-    VVertex LocalVtx[3];
+    VPolyVertex LocalVtx[3];
     VVertex TransVtx[3];
 
     VColorARGB LitColor[3];
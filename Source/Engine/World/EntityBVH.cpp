@@ -0,0 +1,344 @@
+#include <algorithm>
+#include "Engine/Graphics/Rendering/OcclusionBuffer.h"
+#include "Engine/World/EntityBVH.h"
+
+namespace Volition
+{
+
+void VEntityBVH::Update(const TArray<VEntity*>& Entities, const VLight* ShadowMakingLight, f32 YShadowPosition)
+{
+    if (bDirty)
+    {
+        Leaves.Clear();
+
+        for (const auto Entity : Entities)
+        {
+            if (Entity && Entity->Mesh)
+            {
+                Leaves.EmplaceBack(VLeaf{ Entity });
+            }
+        }
+    }
+
+    if (ShadowMakingLight && !ShadowMakingLight->bActive)
+    {
+        ShadowMakingLight = nullptr;
+    }
+
+    for (auto& Leaf : Leaves)
+    {
+        ComputeLeafBounds(Leaf, ShadowMakingLight, YShadowPosition);
+    }
+
+    if (bDirty)
+    {
+        Build();
+        bDirty = false;
+    }
+
+    // Refit, children always go after their parent
+    for (i32f NodeIndex = (i32f)Nodes.GetLength() - 1; NodeIndex >= 0; --NodeIndex)
+    {
+        VNode& Node = Nodes[NodeIndex];
+
+        if (Node.Right)
+        {
+            const VNode& Left = Nodes[NodeIndex + 1];
+            const VNode& Right = Nodes[Node.Right];
+
+            for (i32f i = 0; i < 3; ++i)
+            {
+                Node.Min.C[i] = VLN_MIN(Left.Min.C[i], Right.Min.C[i]);
+                Node.Max.C[i] = VLN_MAX(Left.Max.C[i], Right.Max.C[i]);
+            }
+            Node.bUnbounded = Left.bUnbounded || Right.bUnbounded;
+        }
+        else
+        {
+            const VLeaf& First = Leaves[Node.FirstLeaf];
+
+            Node.Min = First.Min;
+            Node.Max = First.Max;
+            Node.bUnbounded = First.bUnbounded;
+
+            for (i32f LeafIndex = Node.FirstLeaf + 1; LeafIndex < Node.FirstLeaf + Node.NumLeaves; ++LeafIndex)
+            {
+                const VLeaf& Leaf = Leaves[LeafIndex];
+
+                for (i32f i = 0; i < 3; ++i)
+                {
+                    Node.Min.C[i] = VLN_MIN(Node.Min.C[i], Leaf.Min.C[i]);
+                    Node.Max.C[i] = VLN_MAX(Node.Max.C[i], Leaf.Max.C[i]);
+                }
+                Node.bUnbounded = Node.bUnbounded || Leaf.bUnbounded;
+            }
+        }
+    }
+}
+
+const TArray<VEntity*>& VEntityBVH::Cull(const VCamera& Camera, const VOcclusionBuffer* OcclusionBuffer)
+{
+    VisibleEntities.Clear();
+    CulledEntities.Clear();
+
+    if (Nodes.GetLength() == 0)
+    {
+        return VisibleEntities;
+    }
+
+    i32 Stack[64];
+    i32f StackSize = 0;
+    Stack[StackSize++] = 0;
+
+    while (StackSize > 0)
+    {
+        const i32 NodeIndex = Stack[--StackSize];
+        const VNode& Node = Nodes[NodeIndex];
+
+        ETestResult Result = Node.bUnbounded ? Intersects : TestBounds(Camera, Node.Min, Node.Max);
+
+        if (Result != Outside && !Node.bUnbounded && OcclusionBuffer)
+        {
+            if (OcclusionBuffer->IsOccluded(Node.Min, Node.Max))
+            {
+                Result = Outside;
+            }
+            else if (Result == Inside)
+            {
+                // Children still can be hidden
+                Result = Intersects;
+            }
+        }
+
+        if (Result != Intersects)
+        {
+            TArray<VEntity*>& Dest = Result == Inside ? VisibleEntities : CulledEntities;
+
+            for (i32f LeafIndex = Node.FirstLeaf; LeafIndex < Node.FirstLeaf + Node.NumLeaves; ++LeafIndex)
+            {
+                Dest.EmplaceBack(Leaves[LeafIndex].Entity);
+            }
+            continue;
+        }
+
+        if (Node.Right)
+        {
+            Stack[StackSize++] = Node.Right;
+            Stack[StackSize++] = NodeIndex + 1;
+        }
+        else
+        {
+            for (i32f LeafIndex = Node.FirstLeaf; LeafIndex < Node.FirstLeaf + Node.NumLeaves; ++LeafIndex)
+            {
+                const VLeaf& Leaf = Leaves[LeafIndex];
+
+                if (Leaf.bUnbounded ||
+                    (TestBounds(Camera, Leaf.Min, Leaf.Max) != Outside && !(OcclusionBuffer && OcclusionBuffer->IsOccluded(Leaf.Min, Leaf.Max))))
+                {
+                    VisibleEntities.EmplaceBack(Leaf.Entity);
+                }
+                else
+                {
+                    CulledEntities.EmplaceBack(Leaf.Entity);
+                }
+            }
+        }
+    }
+
+    return VisibleEntities;
+}
+
+VEntityBVH::ETestResult VEntityBVH::TestBounds(const VCamera& Camera, const VVector3& Min, const VVector3& Max)
+{
+    const VVector4 Center = {
+        (Min.X + Max.X) * 0.5f,
+        (Min.Y + Max.Y) * 0.5f,
+        (Min.Z + Max.Z) * 0.5f,
+        1.0f
+    };
+    const VVector4 Extents = {
+        (Max.X - Min.X) * 0.5f,
+        (Max.Y - Min.Y) * 0.5f,
+        (Max.Z - Min.Z) * 0.5f,
+        0.0f
+    };
+    const f32 Radius = Extents.GetLength();
+
+    VVector4 Pos;
+    VMatrix44::MulVecMat(Center, Camera.MatCamera, Pos);
+
+    if (Pos.Z + Radius < Camera.ZNearClip || Pos.Z - Radius > Camera.ZFarClip)
+    {
+        return Outside;
+    }
+
+    ETestResult Result = (Pos.Z - Radius >= Camera.ZNearClip && Pos.Z + Radius <= Camera.ZFarClip) ? Inside : Intersects;
+
+    // Camera space clip planes go through origin
+    const VPlane3* Planes[4] = { &Camera.LeftClipPlane, &Camera.RightClipPlane, &Camera.TopClipPlane, &Camera.BottomClipPlane };
+    for (i32f i = 0; i < 4; ++i)
+    {
+        const VVector3& N = Planes[i]->N;
+        const f32 Dist = N.X * Pos.X + N.Y * Pos.Y + N.Z * Pos.Z;
+
+        if (Dist > Radius)
+        {
+            return Outside;
+        }
+        else if (Dist > -Radius)
+        {
+            Result = Intersects;
+        }
+    }
+
+    return Result;
+}
+
+b32 VEntityBVH::ComputeShadowBounds(const VVector3& Min, const VVector3& Max, const VPoint4& LightPos, f32 YShadowPosition, VVector3& OutMin, VVector3& OutMax)
+{
+    if (LightPos.Y <= Max.Y)
+    {
+        return false;
+    }
+
+    // Shadow is projection from light onto Y plane, it's inside projection of box corners
+    for (i32f Corner = 0; Corner < 8; ++Corner)
+    {
+        const VVector3 Pos = {
+            (Corner & 1) ? Max.X : Min.X,
+            (Corner & 2) ? Max.Y : Min.Y,
+            (Corner & 4) ? Max.Z : Min.Z,
+        };
+        const VVector3 Direction = { Pos.X - LightPos.X, Pos.Y - LightPos.Y, Pos.Z - LightPos.Z };
+        const f32 T = (YShadowPosition - LightPos.Y) / Direction.Y;
+
+        const f32 X = LightPos.X + T * Direction.X;
+        const f32 Z = LightPos.Z + T * Direction.Z;
+
+        if (Corner == 0)
+        {
+            OutMin = { X, YShadowPosition, Z };
+            OutMax = { X, YShadowPosition, Z };
+            continue;
+        }
+
+        OutMin.X = VLN_MIN(OutMin.X, X);
+        OutMax.X = VLN_MAX(OutMax.X, X);
+        OutMin.Z = VLN_MIN(OutMin.Z, Z);
+        OutMax.Z = VLN_MAX(OutMax.Z, Z);
+    }
+
+    return true;
+}
+
+void VEntityBVH::Build()
+{
+    Nodes.Clear();
+
+    if (Leaves.GetLength() > 0)
+    {
+        Nodes.Reserve(Leaves.GetLength() * 2);
+        BuildNode(0, (i32)Leaves.GetLength());
+    }
+}
+
+i32 VEntityBVH::BuildNode(i32 FirstLeaf, i32 NumLeaves)
+{
+    const i32 NodeIndex = (i32)Nodes.GetLength();
+
+    VNode& Node = Nodes.EmplaceBack();
+    Node.Right = 0;
+    Node.FirstLeaf = FirstLeaf;
+    Node.NumLeaves = NumLeaves;
+
+    if (NumLeaves <= MaxLeafSize)
+    {
+        return NodeIndex;
+    }
+
+    // Split by median of centers along the longest axis
+    VVector3 Min = { Leaves[FirstLeaf].Min.X + Leaves[FirstLeaf].Max.X, Leaves[FirstLeaf].Min.Y + Leaves[FirstLeaf].Max.Y, Leaves[FirstLeaf].Min.Z + Leaves[FirstLeaf].Max.Z };
+    VVector3 Max = Min;
+
+    for (i32f LeafIndex = FirstLeaf + 1; LeafIndex < FirstLeaf + NumLeaves; ++LeafIndex)
+    {
+        const VLeaf& Leaf = Leaves[LeafIndex];
+
+        for (i32f i = 0; i < 3; ++i)
+        {
+            const f32 Center = Leaf.Min.C[i] + Leaf.Max.C[i];
+
+            Min.C[i] = VLN_MIN(Min.C[i], Center);
+            Max.C[i] = VLN_MAX(Max.C[i], Center);
+        }
+    }
+
+    i32f Axis = 0;
+    for (i32f i = 1; i < 3; ++i)
+    {
+        if (Max.C[i] - Min.C[i] > Max.C[Axis] - Min.C[Axis])
+        {
+            Axis = i;
+        }
+    }
+
+    const i32 Middle = FirstLeaf + NumLeaves / 2;
+    VLeaf* LeafData = Leaves.GetData();
+
+    std::nth_element(
+        LeafData + FirstLeaf, LeafData + Middle, LeafData + FirstLeaf + NumLeaves,
+        [Axis](const VLeaf& A, const VLeaf& B)
+        {
+            return A.Min.C[Axis] + A.Max.C[Axis] < B.Min.C[Axis] + B.Max.C[Axis];
+        }
+    );
+
+    BuildNode(FirstLeaf, Middle - FirstLeaf);
+    const i32 Right = BuildNode(Middle, FirstLeaf + NumLeaves - Middle);
+
+    // Node reference could be invalidated by children
+    Nodes[NodeIndex].Right = Right;
+
+    return NodeIndex;
+}
+
+void VEntityBVH::ComputeLeafBounds(VLeaf& Leaf, const VLight* ShadowMakingLight, f32 YShadowPosition) const
+{
+    const VMesh* Mesh = Leaf.Entity->Mesh;
+
+    // Radius over all frames, so animation doesn't need to be updated before culling
+    f32 Radius = 0.0f;
+    if (Mesh->MaxRadiusList)
+    {
+        for (i32f FrameIndex = 0; FrameIndex < Mesh->NumFrames; ++FrameIndex)
+        {
+            Radius = VLN_MAX(Radius, Mesh->MaxRadiusList[FrameIndex]);
+        }
+    }
+
+    Leaf.Min = { Mesh->Position.X - Radius, Mesh->Position.Y - Radius, Mesh->Position.Z - Radius };
+    Leaf.Max = { Mesh->Position.X + Radius, Mesh->Position.Y + Radius, Mesh->Position.Z + Radius };
+    Leaf.bUnbounded = !(Mesh->Attr & EMeshAttr::CanBeCulled);
+
+    if (~Mesh->Attr & EMeshAttr::CastShadow || !ShadowMakingLight || Leaf.bUnbounded)
+    {
+        return;
+    }
+
+    // Leaf covers both mesh and its shadow, each of them is culled separately later
+    VVector3 ShadowMin, ShadowMax;
+
+    if (!ComputeShadowBounds(Leaf.Min, Leaf.Max, ShadowMakingLight->Position, YShadowPosition, ShadowMin, ShadowMax))
+    {
+        Leaf.bUnbounded = true;
+        return;
+    }
+
+    for (i32f i = 0; i < 3; ++i)
+    {
+        Leaf.Min.C[i] = VLN_MIN(Leaf.Min.C[i], ShadowMin.C[i]);
+        Leaf.Max.C[i] = VLN_MAX(Leaf.Max.C[i], ShadowMax.C[i]);
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Common/Types/Array.h"
+#include "Engine/Graphics/Scene/Camera.h"
+#include "Engine/Graphics/Scene/Light.h"
+#include "Engine/World/Entity.h"
+
+namespace Volition
+{
+
+class VOcclusionBuffer;
+
+/**
+    Bounding volume hierarchy over entity bounding spheres.
+    Rebuilt when entity set changes, otherwise refitted every frame
+*/
+class VEntityBVH
+{
+public:
+    enum ETestResult
+    {
+        Outside = 0,
+        Intersects,
+        Inside
+    };
+
+private:
+    static constexpr i32f MaxLeafSize = 2;
+
+    struct VLeaf
+    {
+        VEntity* Entity;
+        VVector3 Min;
+        VVector3 Max;
+        b32 bUnbounded; /** Can't be culled, i.e. mesh without EMeshAttr::CanBeCulled */
+    };
+
+    struct VNode
+    {
+        VVector3 Min;
+        VVector3 Max;
+        b32 bUnbounded;
+
+        i32 Right;     /** 0 for leaf nodes, left child is always next node */
+        i32 FirstLeaf;
+        i32 NumLeaves;
+    };
+
+private:
+    TArray<VLeaf> Leaves;
+    TArray<VNode> Nodes;
+    TArray<VEntity*> VisibleEntities;
+    TArray<VEntity*> CulledEntities;
+
+    b32 bDirty = true;
+
+public:
+    VLN_FINLINE void MarkDirty()
+    {
+        bDirty = true;
+    }
+
+    /** Rebuilds tree if needed and refits bounds, shadow of casters is included if light is given */
+    void Update(const TArray<VEntity*>& Entities, const VLight* ShadowMakingLight, f32 YShadowPosition);
+
+    /** Returns entities which bounds intersect camera frustum and aren't hidden by occluders */
+    const TArray<VEntity*>& Cull(const VCamera& Camera, const VOcclusionBuffer* OcclusionBuffer = nullptr);
+
+    /** Entities rejected by last Cull() */
+    VLN_FINLINE const TArray<VEntity*>& GetCulledEntities() const
+    {
+        return CulledEntities;
+    }
+
+    VLN_FINLINE i32 GetNumEntities() const
+    {
+        return (i32)Leaves.GetLength();
+    }
+
+    /** Sphere around world space box against camera frustum */
+    static ETestResult TestBounds(const VCamera& Camera, const VVector3& Min, const VVector3& Max);
+
+    /** Bounds of box shadow on Y plane, false if light isn't above box and shadow is unbounded */
+    static b32 ComputeShadowBounds(const VVector3& Min, const VVector3& Max, const VPoint4& LightPos, f32 YShadowPosition, VVector3& OutMin, VVector3& OutMax);
+
+private:
+    void Build();
+    i32 BuildNode(i32 FirstLeaf, i32 NumLeaves);
+
+    void ComputeLeafBounds(VLeaf& Leaf, const VLight* ShadowMakingLight, f32 YShadowPosition) const;
+};
+
+}
\ No newline at end of file
@@ -39,6 +39,7 @@ void VWorld::ShutDown(EWorldShutDownReason Reason)
         }
     }
     Entities.Clear();
+    EntityBVH.MarkDirty();
 
     for (auto& Material : Materials)
     {
@@ -81,6 +82,7 @@ void VWorld::DestroyEntity(VEntity* Entity)
     if (Entity)
     {
         Entities.Remove(Entity);
+        EntityBVH.MarkDirty();
         Entity->Destroy();
         delete Entity;
     }
@@ -4,6 +4,7 @@
 #include "Engine/Graphics/Scene/Light.h"
 #include "Engine/Graphics/Scene/Material.h"
 #include "Engine/World/Entity.h"
+#include "Engine/World/EntityBVH.h"
 #include "Engine/World/GameState.h"
 
 namespace Volition
@@ -31,6 +32,8 @@ private:
     VGameState* NextGameState;
 
     TArray<VEntity*> Entities;
+    VEntityBVH EntityBVH;
+
     TArray<VMaterial> Materials;
 
     TArray<VLight> Lights;
@@ -88,6 +91,7 @@ template<typename T>
 VLN_INLINE T* VWorld::SpawnEntity()
 {
     VEntity* Entity = Entities.EmplaceBack(new T());
+    EntityBVH.MarkDirty();
     Entity->Init();
     return (T*)Entity;
 }